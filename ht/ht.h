@@ -53,6 +53,24 @@
  *   - Returns: pointer to the new map or NULL on error
  *   - Example: Map *m = ht_new_map(32);
  * 
+ * Map *ht_new_map_opts(size_t capacity, const ht_mem_opts *opts)
+ *   - Same as ht_new_map() but controls where the entry array lives
+ *   - Parameters: opts - memory placement options, NULL for the defaults
+ *   - opts->flags is a mix of:
+ *       HT_MEM_HUGEPAGE   always mmap the table and madvise(MADV_HUGEPAGE)
+ *       HT_MEM_NOHUGEPAGE mmap the table and opt it out of huge pages
+ *       HT_MEM_HUGETLB    take explicit hugetlbfs pages (MAP_HUGETLB),
+ *                         falls back to a plain mapping if none are free
+ *       HT_MEM_INTERLEAVE interleave pages over the NUMA nodes in opts->nodemask
+ *       HT_MEM_BIND       bind pages to the NUMA nodes in opts->nodemask
+ *   - Tables of HT_MMAP_THRESHOLD bytes or more are always mmap'd and get
+ *     MADV_HUGEPAGE unless HT_MEM_NOHUGEPAGE is given; NUMA placement is
+ *     best effort and is silently skipped where mbind is not available
+ *   - The options stick to the map, every expand allocates the same way
+ *   - Example:
+ *       ht_mem_opts o = { HT_MEM_HUGEPAGE | HT_MEM_INTERLEAVE, 0x3 };
+ *       Map *m = ht_new_map_opts(1 << 28, &o);
+ * 
  * const char *ht_set(Map *m, const char *key, void *value)
  *   - Inserts or updates a key-value pair in the map
  *   - Parameters: m - map pointer, key - string key, value - value pointer
@@ -66,6 +84,28 @@
  *   - Returns: pointer to the value or NULL if key not found
  *   - Example: char *name = (char*)ht_get(map, "name");
  * 
+ * size_t ht_get_batch(Map *m, const char **keys, size_t n, void **values)
+ *   - Looks up n keys at once: hashes a block of keys with ht_hash_batch(),
+ *     prefetches their home slots, then probes, so the cache misses of a
+ *     block overlap instead of being paid one after the other
+ *   - Parameters: values - receives the value of each key, NULL if missing
+ *   - Returns: number of keys found
+ * 
+ * void ht_hash_batch(const char **keys, const size_t *lens, size_t n, uint64_t *out)
+ *   - Computes the map's FNV-1a hash of n keys, out[i] is the same value
+ *     the map itself uses for keys[i]
+ *   - Parameters: lens - key lengths, or NULL to use strlen()
+ *   - Hashes 4 keys side by side as interleaved scalar chains
+ * 
+ * void *ht_delete(Map *m, const char *key)
+ *   - Removes a key from the map, later keys of the probe run are shifted
+ *     back so no tombstones are left behind
+ *   - Parameters: m - map pointer, key - string key to remove
+ *   - Returns: the removed value (the key and value are not freed) or NULL
+ *     if the key is missing (or, with a live snapshot, if copying a chunk
+ *     failed; the map is then unchanged)
+ *   - Example: free(ht_delete(map, "name"));
+ * 
  * size_t ht_length(Map *m)
  *   - Returns the number of key-value pairs in the map
  *   - Parameters: m - map pointer
@@ -78,6 +118,305 @@
  *   - WARNING: This frees both keys and values, assuming they were malloc'd
  *   - Example: ht_destroy(map);
  * 
+ * void ht_free(Map *m)
+ *   - Frees the map and its table but leaves keys and values alone
+ *   - Parameters: m - map pointer
+ *   - Use it when keys/values are owned by someone else (literals, arenas)
+ *   - Example: ht_free(map);
+ * 
+ * STRING INTERNING:
+ * 
+ * Interner *ht_intern_new(size_t capacity)
+ *   - Creates a string interner backed by a Map
+ *   - Strings are copied into an arena owned by the interner
+ *   - Returns: pointer to the interner or NULL on error
+ * 
+ * uint32_t ht_intern(Interner *in, const char *str)
+ *   - Returns the dense ID of str, copying it into the arena the first time
+ *   - IDs start at 0 and grow by one for every new string
+ *   - Returns: HT_INTERN_NONE on error
+ *   - Example: uint32_t id = ht_intern(in, "GET /index.html");
+ * 
+ * uint32_t ht_intern_find(Interner *in, const char *str)
+ *   - Same as ht_intern() but never inserts
+ *   - Returns: the ID or HT_INTERN_NONE if str was never interned
+ * 
+ * const char *ht_intern_lookup(Interner *in, uint32_t id)
+ *   - Reverse lookup, id -> string
+ *   - Returns: the interned copy (stable until ht_intern_destroy) or NULL
+ * 
+ * size_t ht_intern_count(Interner *in)
+ *   - Returns the number of distinct strings interned so far
+ * 
+ * void ht_intern_destroy(Interner *in)
+ *   - Frees the interner, its arena and every interned string
+ * 
+ *   Interner *in = ht_intern_new(64);
+ *   uint32_t a = ht_intern(in, "cpu.load");
+ *   uint32_t b = ht_intern(in, "cpu.load");   // a == b
+ *   printf("%s\n", ht_intern_lookup(in, a));  // cpu.load
+ *   ht_intern_destroy(in);
+ * 
+ * SNAPSHOTS:
+ * 
+ * MapSnapshot *ht_snapshot(Map *m)
+ *   - Takes a consistent, read-only view of the map without copying it
+ *   - The entry array is split in chunks of HT_SNAPSHOT_CHUNK slots; the
+ *     first write to a chunk while the snapshot is alive copies that chunk
+ *     into the snapshot, untouched chunks are shared with the map
+ *   - When the map expands, the snapshot adopts the old array instead
+ *   - Only one snapshot per map can be alive at a time
+ *   - Returns: pointer to the snapshot or NULL on error
+ * 
+ * void *ht_snapshot_get(MapSnapshot *s, const char *key)
+ *   - Same as ht_get(), as of the moment the snapshot was taken
+ * 
+ * size_t ht_snapshot_length(MapSnapshot *s)
+ *   - Number of items the map had when the snapshot was taken
+ * 
+ * int ht_snapshot_next(MapSnapshot *s, size_t *iter, const char **key, void **value)
+ *   - Iterates the snapshot; start with *iter = 0
+ *   - Returns: 1 and fills key/value while there are items, 0 at the end
+ * 
+ * void ht_snapshot_release(MapSnapshot *s)
+ *   - Drops the snapshot, s must not be used afterwards
+ * 
+ *   The thread mutating the map calls ht_snapshot(); the snapshot can then
+ *   be read and released from another thread while the map keeps changing:
+ * 
+ *   MapSnapshot *snap = ht_snapshot(map);
+ *   // background thread:
+ *   size_t it = 0; const char *k; void *v;
+ *   while(ht_snapshot_next(snap, &it, &k, &v)) serialize(k, v);
+ *   ht_snapshot_release(snap);
+ * 
+ *   Keys and values are not copied, they must outlive the snapshot.
+ * 
+ * PARALLEL BUILD / MERGE:
+ * 
+ * Map *ht_build_parallel(const char **keys, void **values, size_t n, int nthreads)
+ *   - Builds a map from n key/value pairs using nthreads threads
+ *   - Keys are radix-partitioned by the table region their hash lands in,
+ *     then every thread fills its own region of the table with no locking;
+ *     the few probes that run off the end of a region are finished serially
+ *   - Later duplicates win, like calling ht_set() in order
+ *   - Returns: the new map or NULL on error
+ *   - Example: Map *m = ht_build_parallel(keys, values, n, 8);
+ * 
+ * int ht_merge(Map *dst, Map *src)
+ *   - Inserts every item of src into dst, in parallel over all online CPUs
+ *     once src has HT_MERGE_PARALLEL_MIN items, on the caller below that
+ *   - Values from src win on duplicate keys
+ *   - dst now points to the keys/values of src, release src with ht_free()
+ *   - Returns: 0 on success, -1 on error (dst may then hold part of src)
+ * 
+ * TSV FILES:
+ * 
+ * TsvMap *ht_load_tsv(const char *path)
+ *   - Maps a key<TAB>value per line text file and indexes it in place
+ *   - Keys and values are (offset, length) views into the mapping, nothing
+ *     is copied or allocated per line; the TsvMap owns the mapping
+ *   - Lines without a TAB get an empty value, lines with an empty key are
+ *     skipped, a trailing \r is dropped, later duplicates win
+ *   - Returns: the map or NULL if the file can't be opened or mapped
+ * 
+ * const char *ht_tsv_get(TsvMap *m, const char *key, size_t *len)
+ *   - Looks up a NUL terminated key
+ *   - Returns: pointer to the value inside the mapping (NOT NUL terminated)
+ *     and its length in *len, or NULL if the key is missing
+ *   - Example:
+ *       size_t len;
+ *       const char *v = ht_tsv_get(m, "user:42", &len);
+ *       if(v) printf("%.*s\n", (int)len, v);
+ * 
+ * const char *ht_tsv_get_n(TsvMap *m, const char *key, size_t key_len, size_t *len)
+ *   - Same as ht_tsv_get() for keys that are not NUL terminated
+ * 
+ * size_t ht_tsv_length(TsvMap *m)
+ *   - Number of distinct keys in the file
+ * 
+ * void ht_tsv_destroy(TsvMap *m)
+ *   - Unmaps the file and frees the table
+ * 
+ * CONCURRENT INSERT-ONLY MAP:
+ * 
+ * AtomicMap *ht_atomic_new(size_t capacity)
+ *   - Creates a map many threads can insert into and read at once, lock free
+ *   - There is no update or delete; threads claim empty slots with a
+ *     compare-and-swap on the key pointer
+ *   - When the table fills up a new sub-table, twice as large, is chained
+ *     after it; nothing is ever rehashed or blocked on
+ *   - Returns: pointer to the map or NULL on error
+ * 
+ * void *ht_atomic_insert(AtomicMap *m, const char *key, void *value)
+ *   - Inserts key if it is not there yet, value must not be NULL
+ *   - Returns: the value now stored for key (value, or the one that won
+ *     the race), NULL on error
+ *   - Example: Symbol *sym = ht_atomic_insert(table, name, fresh_symbol);
+ * 
+ * void *ht_atomic_get(AtomicMap *m, const char *key)
+ *   - Returns: the value of key or NULL if it is not there
+ * 
+ * size_t ht_atomic_length(AtomicMap *m)
+ *   - Number of keys inserted so far
+ * 
+ * void ht_atomic_destroy(AtomicMap *m)
+ *   - Frees the tables, keys and values are left alone
+ *   - Must not run concurrently with any other call
+ * 
+ * DISK-BACKED MAP:
+ * 
+ * DiskMap *ht_disk_open(const char *path, size_t pool_pages)
+ *   - Opens (or creates) a map stored in a file, for key sets larger than RAM
+ *   - Uses extendible hashing: an in-memory directory points to fixed-size
+ *     HT_DISK_PAGE_SIZE buckets in the file, a full bucket splits in two
+ *     and only those two pages are written, the rest of the file is left alone
+ *   - Up to pool_pages buckets are cached in memory (clock eviction, at least 2)
+ *   - Returns: the map or NULL on error
+ * 
+ * int ht_disk_set(DiskMap *d, const char *key, const void *value, size_t len)
+ *   - Inserts or replaces key with a copy of len bytes of value
+ *   - Returns: 0 on success, -1 on error (I/O, or key + value don't fit a page)
+ * 
+ * const void *ht_disk_get(DiskMap *d, const char *key, size_t *len)
+ *   - Reads at most one page from the file when the bucket is not cached
+ *   - Returns: pointer to the value inside the page cache, valid until the
+ *     next call on d, and its length in *len; NULL if key is missing
+ *   - The value is not aligned, memcpy it out before using it as a struct
+ * 
+ * int ht_disk_delete(DiskMap *d, const char *key)
+ *   - Returns: 0 if key was removed, -1 if it wasn't there
+ * 
+ * size_t ht_disk_length(DiskMap *d)
+ *   - Number of keys stored
+ * 
+ * int ht_disk_sync(DiskMap *d)
+ *   - Writes dirty pages and the directory and flushes them to disk
+ * 
+ * int ht_disk_close(DiskMap *d)
+ *   - Syncs and frees the map, returns -1 if the final sync failed
+ * 
+ *   DiskMap *d = ht_disk_open("/data/index.ht", 1024);
+ *   ht_disk_set(d, "user:42", &profile, sizeof(profile));
+ *   size_t len;
+ *   const void *v = ht_disk_get(d, "user:42", &len);
+ *   if(v) memcpy(&profile, v, len);
+ *   ht_disk_close(d);
+ * 
+ * DURABLE MAP (WRITE-AHEAD LOG):
+ * 
+ * DurableMap *ht_durable_open(const char *dir)
+ *   - Opens a crash-safe map kept in dir (created if missing)
+ *   - Every set/delete appends a compact binary record to dir/wal; records
+ *     are buffered and made durable together by one fdatasync (group commit)
+ *   - ht_durable_checkpoint() writes a compacted dir/snapshot and empties the
+ *     log, so recovery maps the last snapshot and only replays the log tail;
+ *     a torn record at the end of the log is dropped
+ *   - Returns: the map or NULL on error
+ * 
+ * int ht_durable_set(DurableMap *d, const char *key, const void *value, size_t len)
+ * int ht_durable_delete(DurableMap *d, const char *key)
+ *   - Apply the change in memory and append it to the log buffer
+ *   - Once HT_WAL_BATCH_BYTES are buffered they are committed right away
+ *   - Returns: 0 on success, -1 on error (delete: key not found)
+ * 
+ * int ht_durable_commit(DurableMap *d)
+ *   - Blocks until every change appended so far (by any thread) is on disk;
+ *     concurrent callers share a single write + fdatasync
+ *   - Returns: 0 on success, -1 on I/O error
+ * 
+ * const void *ht_durable_get(DurableMap *d, const char *key, size_t *len)
+ *   - Returns: the value and its length, valid until key is set or deleted
+ *     again or the next checkpoint; NULL if key is missing
+ * 
+ * int ht_durable_checkpoint(DurableMap *d)
+ *   - Commits, writes a compacted snapshot, renames it in place and
+ *     truncates the log; writers are blocked meanwhile
+ * 
+ * size_t ht_durable_length(DurableMap *d)
+ * int ht_durable_close(DurableMap *d)
+ *   - close commits pending changes, then frees everything
+ * 
+ *   DurableMap *d = ht_durable_open("/var/lib/app/sessions");
+ *   ht_durable_set(d, "sid:9f2c", token, token_len);
+ *   ht_durable_commit(d);                     // durable from here on
+ *   ht_durable_close(d);
+ * 
+ * COMPACT MAP:
+ * 
+ * CompactMap *ht_compact_new(size_t capacity)
+ *   - Creates a map with 8-byte slots instead of 16-byte ht_entry ones
+ *   - A slot holds a 32-bit offset into a key arena, a 16-bit fingerprint
+ *     of the hash and the 16-bit key length; most non-matching slots are
+ *     rejected from the slot alone, without touching the key bytes
+ *   - Keys are copied into the arena next to their value (max 65535 bytes)
+ *   - Returns: pointer to the map or NULL on error
+ * 
+ * int ht_compact_set(CompactMap *m, const char *key, void *value)
+ *   - Inserts or updates a key, value must not be NULL
+ *   - Returns: 0 on success, -1 on error
+ * 
+ * void *ht_compact_get(CompactMap *m, const char *key)
+ *   - Returns: the value or NULL if key is not found
+ * 
+ * size_t ht_compact_length(CompactMap *m)
+ * void ht_compact_destroy(CompactMap *m)
+ *   - destroy frees the table and the arena (with the keys), not the values
+ * 
+ * INLINE KEY MAP:
+ * 
+ * InlineMap *ht_inline_new(size_t capacity)
+ *   - Creates a map that stores keys of up to HT_INLINE_KEY_MAX bytes
+ *     (15 by default, define it before including to change it) inside the
+ *     slot itself; longer keys fall back to a pointer, like Map
+ *   - With the default size a slot is 32 bytes and the table is 64-byte
+ *     aligned, so looking up a short key touches a single cache line
+ *   - Returns: pointer to the map or NULL on error
+ * 
+ * int ht_inline_set(InlineMap *m, const char *key, void *value)
+ *   - Inserts or updates a key, value must not be NULL
+ *   - Short keys are copied, long keys must stay valid (shallow, like Map)
+ *   - Returns: 0 on success, -1 on error
+ * 
+ * void *ht_inline_get(InlineMap *m, const char *key)
+ *   - Returns: the value or NULL if key is not found
+ * 
+ * size_t ht_inline_length(InlineMap *m)
+ * void ht_inline_destroy(InlineMap *m)
+ *   - destroy frees the table only
+ * 
+ * MULTIMAP:
+ * 
+ * MultiMap *ht_multimap_new(size_t capacity)
+ *   - Creates a map where each key holds a sequence of values, kept in
+ *     insertion order in contiguous chunks that double in size as the
+ *     group grows (up to HT_MULTIMAP_CHUNK_MAX values per chunk)
+ *   - Returns: pointer to the multimap or NULL on error
+ * 
+ * int ht_multimap_append(MultiMap *mm, const char *key, void *value)
+ *   - Appends value to the group of key, creating the group if needed
+ *   - Keys are shallow like Map, values may be NULL
+ *   - Returns: 0 on success, -1 on error
+ * 
+ * size_t ht_multimap_count(MultiMap *mm, const char *key)
+ *   - Returns: number of values appended to key, 0 if it has none
+ * 
+ * MultiMapIter ht_multimap_range(MultiMap *mm, const char *key)
+ * int ht_multimap_next(MultiMapIter *it, void **value)
+ *   - range returns an iterator over the values of key, next stores the
+ *     following value and returns 1, or 0 when the group is exhausted
+ *   - Appending to the same key while iterating is allowed, new values
+ *     are seen by the iterator
+ *   Example:
+ *     MultiMapIter it = ht_multimap_range(mm, "user:42");
+ *     void *event;
+ *     while(ht_multimap_next(&it, &event)) { ... }
+ * 
+ * size_t ht_multimap_length(MultiMap *mm)
+ * void ht_multimap_destroy(MultiMap *mm)
+ *   - length returns the number of keys
+ *   - destroy frees the groups and the index, not the keys or the values
+ * 
  * ADVANCED EXAMPLE:
  * 
  *   typedef struct {
@@ -120,9 +459,19 @@
 
 #ifdef HT_IMPLEMENTATION
 #include <stdio.h>
+#include <stdlib.h>
 #include <malloc.h>
 #include <stdint.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <errno.h>
 
 #define FNV_OFFSET_BASIS 14695981039346656037UL
 #define FNV_PRIME 1099511628211UL 
@@ -134,28 +483,126 @@ typedef struct {
 } ht_entry;
 
 
+#ifndef HT_MMAP_THRESHOLD
+#define HT_MMAP_THRESHOLD (32UL << 20)
+#endif
+
+#define HT_HUGE_PAGE_SIZE (2UL << 20)
+
+#define HT_MEM_HUGEPAGE   (1 << 0)
+#define HT_MEM_NOHUGEPAGE (1 << 1)
+#define HT_MEM_HUGETLB    (1 << 2)
+#define HT_MEM_INTERLEAVE (1 << 3)
+#define HT_MEM_BIND       (1 << 4)
+
+typedef struct {
+    int flags;
+    unsigned long nodemask;
+} ht_mem_opts;
+
 typedef struct {
     ht_entry *ht;
     size_t capacity;
     size_t items;
+    struct MapSnapshot *snapshot;
+    ht_mem_opts mem;
 } Map;
 
+static int ht__snapshot_touch(Map *m, size_t index);
+static int ht__snapshot_adopt(Map *m);
+
 
 size_t ht_length(Map *m) {
     return m->items;
 }
 
-Map *ht_new_map(size_t capacity) {
+static int ht__mem_mapped(const ht_mem_opts *o, size_t bytes) {
+    return o->flags != 0 || bytes >= HT_MMAP_THRESHOLD;
+}
+
+static size_t ht__mem_length(const ht_mem_opts *o, size_t bytes) {
+    // hugetlbfs mappings must cover whole huge pages
+    if(o->flags & HT_MEM_HUGETLB) {
+        return (bytes + HT_HUGE_PAGE_SIZE - 1) & ~(HT_HUGE_PAGE_SIZE - 1);
+    }
+    return bytes;
+}
+
+static ht_entry *ht__alloc_entries(const ht_mem_opts *o, size_t n) {
+    size_t bytes = n * sizeof(ht_entry);
+    if(!ht__mem_mapped(o, bytes)) {
+        return (ht_entry *)calloc(n, sizeof(ht_entry));
+    }
+
+    size_t len = ht__mem_length(o, bytes);
+    void *p = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if(o->flags & HT_MEM_HUGETLB) {
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if(p == MAP_FAILED) {
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(p == MAP_FAILED) {
+            return NULL;
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(p, len, (o->flags & HT_MEM_NOHUGEPAGE) ? MADV_NOHUGEPAGE : MADV_HUGEPAGE);
+#endif
+    }
+
+    // Placement has to be set before the first touch, mmap'd pages are still untouched here
+#ifdef SYS_mbind
+    if(o->flags & (HT_MEM_INTERLEAVE | HT_MEM_BIND)) {
+        const int mpol_bind = 2, mpol_interleave = 3;
+        int mode = (o->flags & HT_MEM_BIND) ? mpol_bind : mpol_interleave;
+        unsigned long mask = o->nodemask;
+        syscall(SYS_mbind, p, len, mode, &mask, sizeof(mask) * 8, 0);
+    }
+#endif
+
+    return (ht_entry *)p;
+}
+
+static void ht__free_entries(const ht_mem_opts *o, ht_entry *e, size_t n) {
+    if(e == NULL) {
+        return;
+    }
+
+    size_t bytes = n * sizeof(ht_entry);
+    if(ht__mem_mapped(o, bytes)) {
+        munmap(e, ht__mem_length(o, bytes));
+    } else {
+        free(e);
+    }
+}
+
+Map *ht_new_map_opts(size_t capacity, const ht_mem_opts *opts) {
 
     Map *m = (Map *)malloc(sizeof(Map));
+    if(m == NULL) {
+        return NULL;
+    }
 
-    m->ht = (ht_entry *)calloc(capacity, sizeof(ht_entry));
+    m->mem.flags = opts ? opts->flags : 0;
+    m->mem.nodemask = opts ? opts->nodemask : 0;
+    m->ht = ht__alloc_entries(&m->mem, capacity);
+    if(m->ht == NULL && capacity > 0) {
+        free(m);
+        return NULL;
+    }
     m->items = 0;
     m->capacity = capacity;
+    m->snapshot = NULL;
 
     return m;
 }
 
+Map *ht_new_map(size_t capacity) {
+    return ht_new_map_opts(capacity, NULL);
+}
+
 
 static uint64_t ht__hash(const char *key) {
     uint64_t hash = FNV_OFFSET_BASIS;
@@ -166,10 +613,82 @@ static uint64_t ht__hash(const char *key) {
     return hash;
 }
 
+static uint64_t ht__hash_n(const char *key, size_t len) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for(size_t i = 0; i < len; i++) {
+        hash ^= (uint64_t)(unsigned char)key[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// -- Batched hashing
+
+#define HT_HASH_LANES 4
+
+// Four independent chains over the common prefix keep the multiplier busy,
+// a single FNV chain is bound by the multiply latency
+static void ht__hash_lanes(const char **keys, const size_t *lens, uint64_t *out) {
+    size_t shortest = lens[0];
+    for(int l = 1; l < 4; l++) {
+        if(lens[l] < shortest) shortest = lens[l];
+    }
+
+    const unsigned char *k0 = (const unsigned char *)keys[0];
+    const unsigned char *k1 = (const unsigned char *)keys[1];
+    const unsigned char *k2 = (const unsigned char *)keys[2];
+    const unsigned char *k3 = (const unsigned char *)keys[3];
+    uint64_t h0 = FNV_OFFSET_BASIS, h1 = FNV_OFFSET_BASIS, h2 = FNV_OFFSET_BASIS, h3 = FNV_OFFSET_BASIS;
+
+    for(size_t j = 0; j < shortest; j++) {
+        h0 = (h0 ^ k0[j]) * FNV_PRIME;
+        h1 = (h1 ^ k1[j]) * FNV_PRIME;
+        h2 = (h2 ^ k2[j]) * FNV_PRIME;
+        h3 = (h3 ^ k3[j]) * FNV_PRIME;
+    }
+
+    uint64_t h[4] = { h0, h1, h2, h3 };
+    for(int l = 0; l < 4; l++) {
+        for(size_t j = shortest; j < lens[l]; j++) {
+            h[l] = (h[l] ^ (unsigned char)keys[l][j]) * FNV_PRIME;
+        }
+        out[l] = h[l];
+    }
+}
+
+void ht_hash_batch(const char **keys, const size_t *lens, size_t n, uint64_t *out) {
+    size_t own[HT_HASH_LANES];
+    size_t i = 0;
+
+    for(; i + HT_HASH_LANES <= n; i += HT_HASH_LANES) {
+        const size_t *l = lens ? lens + i : own;
+        if(lens == NULL) {
+            for(int k = 0; k < HT_HASH_LANES; k++) {
+                own[k] = strlen(keys[i + k]);
+            }
+        }
+        ht__hash_lanes(keys + i, l, out + i);
+    }
+
+    for(; i < n; i++) {
+        out[i] = lens ? ht__hash_n(keys[i], lens[i]) : ht__hash(keys[i]);
+    }
+}
+
+// A snapshot reader may load a slot the map is writing (and then throws
+// what it read away), so writes go through relaxed atomic stores
+static inline void ht__entry_store(ht_entry *e, const char *key, void *value) {
+    __atomic_store_n(&e->key, key, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->value, value, __ATOMIC_RELAXED);
+}
+
 const char *ht_entry_set(Map *m, size_t index, const char *key, void *value) {
     while(m->ht[index].value != NULL) {
         if(strcmp(m->ht[index].key, key) == 0) {
-            m->ht[index].value = value;
+            if(ht__snapshot_touch(m, index) < 0) {
+                return NULL;
+            }
+            ht__entry_store(&m->ht[index], m->ht[index].key, value);
             return m->ht[index].key;
         }
         index ++;
@@ -178,32 +697,55 @@ const char *ht_entry_set(Map *m, size_t index, const char *key, void *value) {
         }
     }
 
-    m->ht[index].key = key;
-    m->ht[index].value = value;
+    if(ht__snapshot_touch(m, index) < 0) {
+        return NULL;
+    }
+    ht__entry_store(&m->ht[index], key, value);
     m->items++;
 
     return m->ht[index].key;
 }
 
-int ht_expand(Map *m) {
-    size_t new_cap = m->capacity * 2;
+static void ht__place(ht_entry *entries, size_t capacity, ht_entry e) {
+    size_t index = (size_t)(ht__hash(e.key) % capacity);
+    while(entries[index].key != NULL) {
+        index++;
+        if(index >= capacity) {
+            index = 0;
+        }
+    }
+    entries[index] = e;
+}
 
-    if(new_cap < m->capacity) {
+static int ht__resize(Map *m, size_t new_cap) {
+    ht_entry *new_entries = ht__alloc_entries(&m->mem, new_cap);
+    if(new_entries == NULL) {
         return -1;
     }
 
-    ht_entry *new_entries = (ht_entry*)calloc(new_cap, sizeof(ht_entry));
-
-    for(size_t i = 0; i < ht_length(m); i++) {
+    for(size_t i = 0; i < m->capacity; i++) {
         if(m->ht[i].key != NULL)
-            new_entries[i] = m->ht[i];
+            ht__place(new_entries, new_cap, m->ht[i]);
     }
 
+    if(!ht__snapshot_adopt(m)) {
+        ht__free_entries(&m->mem, m->ht, m->capacity);
+    }
     m->capacity = new_cap;
     m->ht = new_entries;
     return 0;
 }
 
+int ht_expand(Map *m) {
+    size_t new_cap = m->capacity * 2;
+
+    if(new_cap < m->capacity) {
+        return -1;
+    }
+
+    return ht__resize(m, new_cap);
+}
+
 const char *ht_set(Map *m, const char *key, void* value) {
     if(key == NULL) {
         return NULL;
@@ -236,6 +778,95 @@ void *ht_get(Map *m, const char *key) {
     return NULL;
 }
 
+#define HT_GET_BATCH 32
+
+size_t ht_get_batch(Map *m, const char **keys, size_t n, void **values) {
+    uint64_t index[HT_GET_BATCH];
+    size_t found = 0;
+
+    for(size_t i = 0; i < n; i += HT_GET_BATCH) {
+        size_t count = n - i < HT_GET_BATCH ? n - i : HT_GET_BATCH;
+
+        ht_hash_batch(keys + i, NULL, count, index);
+        for(size_t k = 0; k < count; k++) {
+            index[k] %= m->capacity;
+            __builtin_prefetch(&m->ht[index[k]]);
+        }
+
+        for(size_t k = 0; k < count; k++) {
+            size_t slot = (size_t)index[k];
+            void *value = NULL;
+            while(m->ht[slot].value != NULL) {
+                if(strcmp(m->ht[slot].key, keys[i + k]) == 0) {
+                    value = m->ht[slot].value;
+                    found++;
+                    break;
+                }
+                slot = slot + 1 < m->capacity ? slot + 1 : 0;
+            }
+            values[i + k] = value;
+        }
+    }
+    return found;
+}
+
+void *ht_delete(Map *m, const char *key) {
+    size_t index = (size_t)(ht__hash(key) % m->capacity);
+    while(m->ht[index].value != NULL && strcmp(m->ht[index].key, key) != 0) {
+        index++;
+        if(index >= m->capacity) {
+            index = 0;
+        }
+    }
+
+    void *value = m->ht[index].value;
+    if(value == NULL) {
+        return NULL;
+    }
+
+    // The shift below only writes slots of this run; copy their chunks for
+    // a live snapshot first, so a failed copy leaves the map as it was
+    if(m->snapshot != NULL) {
+        size_t slot = index;
+        do {
+            if(ht__snapshot_touch(m, slot) < 0) {
+                return NULL;
+            }
+            slot = slot + 1 < m->capacity ? slot + 1 : 0;
+        } while(m->ht[slot].value != NULL);
+    }
+
+    // Pull back every later entry of the run whose home slot is not
+    // cyclically between the hole and itself
+    size_t hole = index;
+    size_t next = index;
+    for(;;) {
+        next = next + 1 < m->capacity ? next + 1 : 0;
+        if(m->ht[next].value == NULL) {
+            break;
+        }
+
+        size_t home = (size_t)(ht__hash(m->ht[next].key) % m->capacity);
+        int stays = hole <= next ? (home > hole && home <= next) : (home > hole || home <= next);
+        if(!stays) {
+            ht__entry_store(&m->ht[hole], m->ht[next].key, m->ht[next].value);
+            hole = next;
+        }
+    }
+
+    ht__entry_store(&m->ht[hole], NULL, NULL);
+    m->items--;
+    return value;
+}
+
+
+static void ht__snapshot_detach(Map *m);
+
+void ht_free(Map *m) {
+    ht__snapshot_detach(m);
+    ht__free_entries(&m->mem, m->ht, m->capacity);
+    free(m);
+}
 
 void ht_destroy(Map *m) {
     for(size_t i = 0; i < ht_length(m); i++) {
@@ -243,8 +874,2463 @@ void ht_destroy(Map *m) {
         free(m->ht[i].value);
         free((void *)m->ht[i].key);
     }
-    free(m->ht);
-    free(m);
+    ht_free(m);
+}
+
+
+
+// -- String interning
+
+#define HT_INTERN_NONE UINT32_MAX
+#define HT_INTERN_BLOCK_SIZE 4096
+
+typedef struct ht__intern_block {
+    struct ht__intern_block *next;
+    size_t used;
+    size_t cap;
+    char data[];
+} ht__intern_block;
+
+typedef struct {
+    Map *index;
+    ht__intern_block *blocks;
+    const char **strings;
+    uint32_t count;
+    uint32_t cap;
+} Interner;
+
+Interner *ht_intern_new(size_t capacity) {
+    Interner *in = (Interner *)malloc(sizeof(Interner));
+    if(in == NULL) {
+        return NULL;
+    }
+
+    in->index = ht_new_map(capacity > 0 ? capacity : 16);
+    if(in->index == NULL) {
+        free(in);
+        return NULL;
+    }
+    in->blocks = NULL;
+    in->strings = NULL;
+    in->count = 0;
+    in->cap = 0;
+    return in;
+}
+
+// Blocks never move, so the key pointers kept by the Map stay valid
+static char *ht__intern_copy(Interner *in, const char *str, size_t len) {
+    ht__intern_block *b = in->blocks;
+
+    if(b == NULL || b->cap - b->used < len + 1) {
+        size_t cap = len + 1 > HT_INTERN_BLOCK_SIZE ? len + 1 : HT_INTERN_BLOCK_SIZE;
+        b = (ht__intern_block *)malloc(sizeof(ht__intern_block) + cap);
+        if(b == NULL) {
+            return NULL;
+        }
+        b->used = 0;
+        b->cap = cap;
+        b->next = in->blocks;
+        in->blocks = b;
+    }
+
+    char *dst = b->data + b->used;
+    memcpy(dst, str, len + 1);
+    b->used += len + 1;
+    return dst;
+}
+
+uint32_t ht_intern_find(Interner *in, const char *str) {
+    // IDs are stored shifted by one, a NULL value marks an empty slot
+    uintptr_t v = (uintptr_t)ht_get(in->index, str);
+    return v == 0 ? HT_INTERN_NONE : (uint32_t)(v - 1);
+}
+
+uint32_t ht_intern(Interner *in, const char *str) {
+    if(str == NULL) {
+        return HT_INTERN_NONE;
+    }
+
+    uint32_t id = ht_intern_find(in, str);
+    if(id != HT_INTERN_NONE) {
+        return id;
+    }
+
+    if(in->count == HT_INTERN_NONE - 1) {
+        return HT_INTERN_NONE;
+    }
+
+    if(in->count == in->cap) {
+        uint32_t new_cap = in->cap ? in->cap * 2 : 64;
+        const char **strings = (const char **)realloc(in->strings, new_cap * sizeof(char *));
+        if(strings == NULL) {
+            return HT_INTERN_NONE;
+        }
+        in->strings = strings;
+        in->cap = new_cap;
+    }
+
+    char *copy = ht__intern_copy(in, str, strlen(str));
+    if(copy == NULL) {
+        return HT_INTERN_NONE;
+    }
+
+    id = in->count;
+    if(ht_set(in->index, copy, (void *)((uintptr_t)id + 1)) == NULL) {
+        return HT_INTERN_NONE;
+    }
+
+    in->strings[id] = copy;
+    in->count++;
+    return id;
+}
+
+const char *ht_intern_lookup(Interner *in, uint32_t id) {
+    if(id >= in->count) {
+        return NULL;
+    }
+    return in->strings[id];
+}
+
+size_t ht_intern_count(Interner *in) {
+    return in->count;
+}
+
+void ht_intern_destroy(Interner *in) {
+    ht__intern_block *b = in->blocks;
+    while(b != NULL) {
+        ht__intern_block *next = b->next;
+        free(b);
+        b = next;
+    }
+
+    free(in->strings);
+    ht_free(in->index);
+    free(in);
+}
+
+
+// -- Copy-on-write snapshots
+
+#ifndef HT_SNAPSHOT_CHUNK
+#define HT_SNAPSHOT_CHUNK 512
+#endif
+
+enum {
+    HT__SNAPSHOT_LIVE,
+    HT__SNAPSHOT_RELEASED,
+    HT__SNAPSHOT_ORPHANED
+};
+
+typedef struct MapSnapshot {
+    ht_entry *base;
+    _Atomic(ht_entry *) *chunks;
+    size_t n_chunks;
+    size_t capacity;
+    size_t items;
+    ht_mem_opts mem;
+    int owns_base;
+    atomic_int state;
+} MapSnapshot;
+
+static void ht__snapshot_free(MapSnapshot *s) {
+    for(size_t c = 0; c < s->n_chunks; c++) {
+        free(atomic_load_explicit(&s->chunks[c], memory_order_relaxed));
+    }
+    if(s->owns_base) {
+        ht__free_entries(&s->mem, s->base, s->capacity);
+    }
+    free(s->chunks);
+    free(s);
+}
+
+// Frees a snapshot the reader already let go of, returns the live one or NULL
+static MapSnapshot *ht__snapshot_live(Map *m) {
+    MapSnapshot *s = m->snapshot;
+    if(s != NULL && atomic_load_explicit(&s->state, memory_order_acquire) == HT__SNAPSHOT_RELEASED) {
+        ht__snapshot_free(s);
+        m->snapshot = NULL;
+        s = NULL;
+    }
+    return s;
+}
+
+// Called by the map right before it writes m->ht[index], returns -1 if
+// the chunk could not be copied and the write must not happen
+static int ht__snapshot_touch(Map *m, size_t index) {
+    MapSnapshot *s = ht__snapshot_live(m);
+    if(s == NULL || s->owns_base) {
+        return 0;
+    }
+
+    size_t c = index / HT_SNAPSHOT_CHUNK;
+    if(atomic_load_explicit(&s->chunks[c], memory_order_relaxed) != NULL) {
+        return 0;
+    }
+
+    size_t first = c * HT_SNAPSHOT_CHUNK;
+    size_t n = s->capacity - first < HT_SNAPSHOT_CHUNK ? s->capacity - first : HT_SNAPSHOT_CHUNK;
+    ht_entry *copy = (ht_entry *)malloc(n * sizeof(ht_entry));
+    if(copy == NULL) {
+        return -1;
+    }
+    memcpy(copy, s->base + first, n * sizeof(ht_entry));
+
+    // Publish the copy before the live chunk changes under a reader
+    atomic_store_explicit(&s->chunks[c], copy, memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst);
+    return 0;
+}
+
+// Called when the map is about to drop its entry array, returns 1 if the
+// snapshot took ownership of it
+static int ht__snapshot_adopt(Map *m) {
+    MapSnapshot *s = ht__snapshot_live(m);
+    if(s == NULL || s->owns_base) {
+        return 0;
+    }
+    s->owns_base = 1;
+    return 1;
+}
+
+static void ht__snapshot_detach(Map *m) {
+    MapSnapshot *s = m->snapshot;
+    if(s == NULL) {
+        return;
+    }
+
+    int adopted = ht__snapshot_adopt(m);
+    if(m->snapshot == NULL) {
+        return;
+    }
+    m->snapshot = NULL;
+
+    if(adopted) {
+        m->ht = NULL;
+    }
+
+    // Whoever comes last between the map and the reader frees the snapshot
+    if(atomic_exchange(&s->state, HT__SNAPSHOT_ORPHANED) == HT__SNAPSHOT_RELEASED) {
+        ht__snapshot_free(s);
+    }
+}
+
+MapSnapshot *ht_snapshot(Map *m) {
+    if(ht__snapshot_live(m) != NULL) {
+        return NULL;
+    }
+
+    MapSnapshot *s = (MapSnapshot *)malloc(sizeof(MapSnapshot));
+    if(s == NULL) {
+        return NULL;
+    }
+
+    s->n_chunks = (m->capacity + HT_SNAPSHOT_CHUNK - 1) / HT_SNAPSHOT_CHUNK;
+    s->chunks = (_Atomic(ht_entry *) *)calloc(s->n_chunks ? s->n_chunks : 1, sizeof(*s->chunks));
+    if(s->chunks == NULL) {
+        free(s);
+        return NULL;
+    }
+
+    s->base = m->ht;
+    s->capacity = m->capacity;
+    s->items = m->items;
+    s->mem = m->mem;
+    s->owns_base = 0;
+    atomic_init(&s->state, HT__SNAPSHOT_LIVE);
+
+    m->snapshot = s;
+    return s;
+}
+
+static ht_entry ht__snapshot_read(MapSnapshot *s, size_t index) {
+    size_t c = index / HT_SNAPSHOT_CHUNK;
+    ht_entry *chunk = atomic_load_explicit(&s->chunks[c], memory_order_acquire);
+
+    if(chunk == NULL) {
+        ht_entry e;
+        e.key = __atomic_load_n(&s->base[index].key, __ATOMIC_RELAXED);
+        e.value = __atomic_load_n(&s->base[index].value, __ATOMIC_RELAXED);
+
+        // The map publishes a chunk copy before writing to it; if one showed
+        // up while we were reading, the live slot may be torn, use the copy
+        atomic_thread_fence(memory_order_acquire);
+        chunk = atomic_load_explicit(&s->chunks[c], memory_order_relaxed);
+        if(chunk == NULL) {
+            return e;
+        }
+    }
+
+    return chunk[index - c * HT_SNAPSHOT_CHUNK];
+}
+
+void *ht_snapshot_get(MapSnapshot *s, const char *key) {
+    if(s->capacity == 0) {
+        return NULL;
+    }
+
+    size_t index = (size_t)(ht__hash(key) % s->capacity);
+    for(size_t probes = 0; probes < s->capacity; probes++) {
+        ht_entry e = ht__snapshot_read(s, index);
+        if(e.value == NULL) {
+            return NULL;
+        }
+        if(strcmp(e.key, key) == 0) {
+            return e.value;
+        }
+        index++;
+
+        if(index >= s->capacity) {
+            index = 0;
+        }
+    }
+    return NULL;
+}
+
+size_t ht_snapshot_length(MapSnapshot *s) {
+    return s->items;
+}
+
+int ht_snapshot_next(MapSnapshot *s, size_t *iter, const char **key, void **value) {
+    while(*iter < s->capacity) {
+        ht_entry e = ht__snapshot_read(s, (*iter)++);
+        if(e.value != NULL) {
+            if(key) *key = e.key;
+            if(value) *value = e.value;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void ht_snapshot_release(MapSnapshot *s) {
+    if(atomic_exchange(&s->state, HT__SNAPSHOT_RELEASED) == HT__SNAPSHOT_ORPHANED) {
+        ht__snapshot_free(s);
+    }
+}
+
+
+// -- Parallel build / merge
+
+typedef struct {
+    Map *m;
+    const char **keys;
+    void **values;
+    size_t n;
+    uint64_t *hashes;
+    size_t *order;
+    size_t *offsets;
+    size_t region;
+    int nthreads;
+} ht__build_ctx;
+
+typedef struct {
+    ht__build_ctx *ctx;
+    int id;
+    size_t items;
+    size_t *overflow;
+    size_t n_overflow;
+    size_t cap_overflow;
+    int failed;
+} ht__build_worker;
+
+static void ht__run_workers(ht__build_worker *w, int nthreads, void *(*fn)(void *)) {
+    if(nthreads == 1) {
+        fn(&w[0]);
+        return;
+    }
+
+    pthread_t threads[nthreads];
+    int started[nthreads];
+    for(int t = 0; t < nthreads; t++) {
+        started[t] = pthread_create(&threads[t], NULL, fn, &w[t]) == 0;
+        if(!started[t]) {
+            fn(&w[t]);
+        }
+    }
+    for(int t = 0; t < nthreads; t++) {
+        if(started[t]) pthread_join(threads[t], NULL);
+    }
+}
+
+static size_t ht__build_partition(ht__build_ctx *c, uint64_t hash) {
+    return (size_t)(hash % c->m->capacity) / c->region;
+}
+
+// Phase 1: hash our slice of the input and count keys per partition
+static void *ht__build_hash(void *arg) {
+    ht__build_worker *w = (ht__build_worker *)arg;
+    ht__build_ctx *c = w->ctx;
+    size_t from = c->n * w->id / c->nthreads;
+    size_t to = c->n * (w->id + 1) / c->nthreads;
+    size_t *hist = c->offsets + (size_t)w->id * c->nthreads;
+
+    ht_hash_batch(c->keys + from, NULL, to - from, c->hashes + from);
+    for(size_t i = from; i < to; i++) {
+        hist[ht__build_partition(c, c->hashes[i])]++;
+    }
+    return NULL;
+}
+
+// Phase 2: scatter our slice into the partitions, keeping input order
+static void *ht__build_scatter(void *arg) {
+    ht__build_worker *w = (ht__build_worker *)arg;
+    ht__build_ctx *c = w->ctx;
+    size_t from = c->n * w->id / c->nthreads;
+    size_t to = c->n * (w->id + 1) / c->nthreads;
+    size_t *offsets = c->offsets + (size_t)w->id * c->nthreads;
+
+    for(size_t i = from; i < to; i++) {
+        c->order[offsets[ht__build_partition(c, c->hashes[i])]++] = i;
+    }
+    return NULL;
+}
+
+// Phase 3: fill our region of the table, nobody else writes there
+static void *ht__build_fill(void *arg) {
+    ht__build_worker *w = (ht__build_worker *)arg;
+    ht__build_ctx *c = w->ctx;
+    Map *m = c->m;
+    size_t region_start = (size_t)w->id * c->region;
+    size_t region_end = region_start + c->region < m->capacity ? region_start + c->region : m->capacity;
+
+    // After the scatter, offsets of the last thread mark where each partition ends
+    size_t *ends = c->offsets + (size_t)(c->nthreads - 1) * c->nthreads;
+    size_t from = w->id == 0 ? 0 : ends[w->id - 1];
+    size_t to = ends[w->id];
+
+    for(size_t o = from; o < to; o++) {
+        size_t i = c->order[o];
+        size_t index = (size_t)(c->hashes[i] % m->capacity);
+
+        while(index < region_end && m->ht[index].value != NULL) {
+            if(strcmp(m->ht[index].key, c->keys[i]) == 0) {
+                break;
+            }
+            index++;
+        }
+
+        if(index == region_end) {
+            if(w->n_overflow == w->cap_overflow) {
+                size_t cap = w->cap_overflow ? w->cap_overflow * 2 : 64;
+                size_t *grown = (size_t *)realloc(w->overflow, cap * sizeof(size_t));
+                if(grown == NULL) {
+                    w->failed = 1;
+                    return NULL;
+                }
+                w->overflow = grown;
+                w->cap_overflow = cap;
+            }
+            w->overflow[w->n_overflow++] = i;
+            continue;
+        }
+
+        if(m->ht[index].value == NULL) {
+            m->ht[index].key = c->keys[i];
+            w->items++;
+        }
+        m->ht[index].value = c->values[i];
+    }
+    return NULL;
+}
+
+static int ht__parallel_insert(Map *m, const char **keys, void **values, size_t n, int nthreads) {
+    if(nthreads < 1) {
+        nthreads = 1;
+    }
+    if((size_t)nthreads > m->capacity) {
+        nthreads = (int)m->capacity;
+    }
+
+    ht__build_ctx c;
+    c.m = m;
+    c.keys = keys;
+    c.values = values;
+    c.n = n;
+    c.nthreads = nthreads;
+    c.region = (m->capacity + nthreads - 1) / nthreads;
+    c.hashes = (uint64_t *)malloc(n * sizeof(uint64_t));
+    c.order = (size_t *)malloc(n * sizeof(size_t));
+    c.offsets = (size_t *)calloc((size_t)nthreads * nthreads, sizeof(size_t));
+    ht__build_worker *w = (ht__build_worker *)calloc(nthreads, sizeof(ht__build_worker));
+
+    if((n && (c.hashes == NULL || c.order == NULL)) || c.offsets == NULL || w == NULL) {
+        free(c.hashes);
+        free(c.order);
+        free(c.offsets);
+        free(w);
+        return -1;
+    }
+
+    for(int t = 0; t < nthreads; t++) {
+        w[t].ctx = &c;
+        w[t].id = t;
+    }
+
+    ht__run_workers(w, nthreads, ht__build_hash);
+
+    // Exclusive prefix sum, partition-major so every partition is contiguous
+    size_t running = 0;
+    for(int p = 0; p < nthreads; p++) {
+        for(int t = 0; t < nthreads; t++) {
+            size_t count = c.offsets[(size_t)t * nthreads + p];
+            c.offsets[(size_t)t * nthreads + p] = running;
+            running += count;
+        }
+    }
+
+    ht__run_workers(w, nthreads, ht__build_scatter);
+    ht__run_workers(w, nthreads, ht__build_fill);
+
+    int failed = 0;
+    for(int t = 0; t < nthreads; t++) {
+        m->items += w[t].items;
+        failed |= w[t].failed;
+    }
+
+    // Spilled probes continue into the next region, finish them in order
+    for(int t = 0; t < nthreads; t++) {
+        for(size_t o = 0; !failed && o < w[t].n_overflow; o++) {
+            size_t i = w[t].overflow[o];
+            ht_entry_set(m, (size_t)(c.hashes[i] % m->capacity), keys[i], values[i]);
+        }
+        free(w[t].overflow);
+    }
+
+    free(c.hashes);
+    free(c.order);
+    free(c.offsets);
+    free(w);
+    return failed ? -1 : 0;
+}
+
+Map *ht_build_parallel(const char **keys, void **values, size_t n, int nthreads) {
+    Map *m = ht_new_map(n * 2 + 16);
+    if(m == NULL || m->ht == NULL) {
+        return NULL;
+    }
+
+    if(ht__parallel_insert(m, keys, values, n, nthreads) < 0) {
+        ht_free(m);
+        return NULL;
+    }
+    return m;
+}
+
+// Below this many items ht_merge() stays on the calling thread, starting
+// the workers three times costs more than the inserts
+#ifndef HT_MERGE_PARALLEL_MIN
+#define HT_MERGE_PARALLEL_MIN 16384
+#endif
+
+int ht_merge(Map *dst, Map *src) {
+    size_t needed = (dst->items + src->items) * 2 + 16;
+    size_t new_cap = dst->capacity;
+    while(new_cap < needed) {
+        new_cap *= 2;
+    }
+
+    // Threads write the table directly, so a live snapshot takes the
+    // current array and the merge goes into a fresh copy
+    if(new_cap != dst->capacity || ht__snapshot_live(dst) != NULL) {
+        if(ht__resize(dst, new_cap) < 0) {
+            return -1;
+        }
+    }
+
+    const char **keys = (const char **)malloc(src->items * sizeof(char *));
+    void **values = (void **)malloc(src->items * sizeof(void *));
+    if(src->items && (keys == NULL || values == NULL)) {
+        free(keys);
+        free(values);
+        return -1;
+    }
+
+    size_t n = 0;
+    for(size_t i = 0; i < src->capacity && n < src->items; i++) {
+        if(src->ht[i].value != NULL) {
+            keys[n] = src->ht[i].key;
+            values[n] = src->ht[i].value;
+            n++;
+        }
+    }
+
+    long cpus = n < HT_MERGE_PARALLEL_MIN ? 1 : sysconf(_SC_NPROCESSORS_ONLN);
+    int result = ht__parallel_insert(dst, keys, values, n, cpus > 0 ? (int)cpus : 1);
+
+    free(keys);
+    free(values);
+    return result;
+}
+
+
+// -- Maps over mmap'd TSV files
+
+typedef struct {
+    uint64_t key_off;
+    uint64_t val_off;
+    uint32_t key_len;
+    uint32_t val_len;
+} ht_view;
+
+typedef struct {
+    ht_view *ht;
+    size_t capacity;
+    size_t items;
+    const char *data;
+    size_t size;
+} TsvMap;
+
+static void ht__tsv_insert(TsvMap *m, ht_view v) {
+    const char *key = m->data + v.key_off;
+    size_t index = (size_t)(ht__hash_n(key, v.key_len) % m->capacity);
+
+    // key_len == 0 marks an empty slot, empty keys never get here
+    while(m->ht[index].key_len != 0) {
+        ht_view *e = &m->ht[index];
+        if(e->key_len == v.key_len && memcmp(m->data + e->key_off, key, v.key_len) == 0) {
+            e->val_off = v.val_off;
+            e->val_len = v.val_len;
+            return;
+        }
+        index++;
+        if(index >= m->capacity) {
+            index = 0;
+        }
+    }
+
+    m->ht[index] = v;
+    m->items++;
+}
+
+void ht_tsv_destroy(TsvMap *m) {
+    if(m->data) {
+        munmap((void *)m->data, m->size);
+    }
+    free(m->ht);
+    free(m);
+}
+
+TsvMap *ht_load_tsv(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    TsvMap *m = (TsvMap *)malloc(sizeof(TsvMap));
+    if(m == NULL) {
+        close(fd);
+        return NULL;
+    }
+
+    m->size = (size_t)st.st_size;
+    m->data = NULL;
+    m->items = 0;
+
+    if(m->size > 0) {
+        void *p = mmap(NULL, m->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED) {
+            close(fd);
+            free(m);
+            return NULL;
+        }
+        m->data = (const char *)p;
+        madvise(p, m->size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    size_t lines = 1;
+    const char *cur = m->data;
+    const char *end = m->data + m->size;
+    while(cur < end && (cur = (const char *)memchr(cur, '\n', end - cur)) != NULL) {
+        lines++;
+        cur++;
+    }
+
+    m->capacity = lines * 2 + 16;
+    m->ht = (ht_view *)calloc(m->capacity, sizeof(ht_view));
+    if(m->ht == NULL) {
+        ht_tsv_destroy(m);
+        return NULL;
+    }
+
+    cur = m->data;
+    while(cur < end) {
+        const char *nl = (const char *)memchr(cur, '\n', end - cur);
+        size_t line_len = (size_t)((nl ? nl : end) - cur);
+        if(line_len > 0 && cur[line_len - 1] == '\r') {
+            line_len--;
+        }
+
+        const char *stop = cur + line_len;
+        const char *tab = (const char *)memchr(cur, '\t', line_len);
+        const char *key_end = tab ? tab : stop;
+        const char *val = tab ? tab + 1 : stop;
+
+        if(key_end > cur) {
+            if((size_t)(key_end - cur) > UINT32_MAX || (size_t)(stop - val) > UINT32_MAX) {
+                ht_tsv_destroy(m);
+                return NULL;
+            }
+            ht_view v;
+            v.key_off = (uint64_t)(cur - m->data);
+            v.key_len = (uint32_t)(key_end - cur);
+            v.val_off = (uint64_t)(val - m->data);
+            v.val_len = (uint32_t)(stop - val);
+            ht__tsv_insert(m, v);
+        }
+
+        if(nl == NULL) {
+            break;
+        }
+        cur = nl + 1;
+    }
+
+    if(m->data) {
+        madvise((void *)m->data, m->size, MADV_RANDOM);
+    }
+    return m;
+}
+
+const char *ht_tsv_get_n(TsvMap *m, const char *key, size_t key_len, size_t *len) {
+    if(key_len == 0) {
+        return NULL;
+    }
+
+    size_t index = (size_t)(ht__hash_n(key, key_len) % m->capacity);
+    while(m->ht[index].key_len != 0) {
+        ht_view *e = &m->ht[index];
+        if(e->key_len == key_len && memcmp(m->data + e->key_off, key, key_len) == 0) {
+            if(len) *len = e->val_len;
+            return m->data + e->val_off;
+        }
+        index++;
+
+        if(index >= m->capacity) {
+            index = 0;
+        }
+    }
+    return NULL;
+}
+
+const char *ht_tsv_get(TsvMap *m, const char *key, size_t *len) {
+    return ht_tsv_get_n(m, key, strlen(key), len);
+}
+
+size_t ht_tsv_length(TsvMap *m) {
+    return m->items;
+}
+
+
+// -- Concurrent insert-only map
+
+#ifndef HT_ATOMIC_MAX_PROBE
+#define HT_ATOMIC_MAX_PROBE 64
+#endif
+
+typedef struct {
+    _Atomic(const char *) key;
+    _Atomic(void *) value;
+} ht_atomic_entry;
+
+typedef struct ht__atomic_table {
+    ht_atomic_entry *ht;
+    size_t capacity;
+    atomic_size_t items;
+    _Atomic(struct ht__atomic_table *) next;
+} ht__atomic_table;
+
+typedef struct {
+    ht__atomic_table *first;
+    atomic_size_t items;
+} AtomicMap;
+
+static ht__atomic_table *ht__atomic_table_new(size_t capacity) {
+    ht__atomic_table *t = (ht__atomic_table *)malloc(sizeof(ht__atomic_table));
+    if(t == NULL) {
+        return NULL;
+    }
+
+    t->ht = (ht_atomic_entry *)calloc(capacity, sizeof(ht_atomic_entry));
+    if(t->ht == NULL) {
+        free(t);
+        return NULL;
+    }
+    t->capacity = capacity;
+    atomic_init(&t->items, 0);
+    atomic_init(&t->next, NULL);
+    return t;
+}
+
+// Chains a bigger table after t, if two threads race the loser frees its own
+static ht__atomic_table *ht__atomic_grow(ht__atomic_table *t) {
+    ht__atomic_table *next = atomic_load_explicit(&t->next, memory_order_acquire);
+    if(next != NULL) {
+        return next;
+    }
+
+    ht__atomic_table *fresh = ht__atomic_table_new(t->capacity * 2);
+    if(fresh == NULL) {
+        return NULL;
+    }
+
+    if(!atomic_compare_exchange_strong_explicit(&t->next, &next, fresh,
+                                                memory_order_acq_rel, memory_order_acquire)) {
+        free(fresh->ht);
+        free(fresh);
+        return next;
+    }
+    return fresh;
+}
+
+AtomicMap *ht_atomic_new(size_t capacity) {
+    AtomicMap *m = (AtomicMap *)malloc(sizeof(AtomicMap));
+    if(m == NULL) {
+        return NULL;
+    }
+
+    m->first = ht__atomic_table_new(capacity > 0 ? capacity : 16);
+    if(m->first == NULL) {
+        free(m);
+        return NULL;
+    }
+    atomic_init(&m->items, 0);
+    return m;
+}
+
+static void *ht__atomic_wait_value(ht_atomic_entry *e) {
+    void *v;
+    while((v = atomic_load_explicit(&e->value, memory_order_acquire)) == NULL) {
+        sched_yield();
+    }
+    return v;
+}
+
+// A key only moves on to the next table when its whole probe window is taken
+// by other keys, and slots are never freed, so every thread walks the same
+// windows for a given key and can't end up inserting it twice
+void *ht_atomic_insert(AtomicMap *m, const char *key, void *value) {
+    if(key == NULL || value == NULL) {
+        return NULL;
+    }
+
+    uint64_t hash = ht__hash(key);
+    ht__atomic_table *t = m->first;
+
+    while(t != NULL) {
+        size_t index = (size_t)(hash % t->capacity);
+        size_t window = t->capacity < HT_ATOMIC_MAX_PROBE ? t->capacity : HT_ATOMIC_MAX_PROBE;
+
+        for(size_t probe = 0; probe < window; probe++) {
+            ht_atomic_entry *e = &t->ht[index];
+            const char *k = atomic_load_explicit(&e->key, memory_order_acquire);
+
+            if(k == NULL) {
+                if(atomic_compare_exchange_strong_explicit(&e->key, &k, key,
+                                                           memory_order_acq_rel, memory_order_acquire)) {
+                    atomic_store_explicit(&e->value, value, memory_order_release);
+                    atomic_fetch_add_explicit(&m->items, 1, memory_order_relaxed);
+
+                    // Past 50% load, have the next table ready before this one is full
+                    size_t items = atomic_fetch_add_explicit(&t->items, 1, memory_order_relaxed) + 1;
+                    if(items > t->capacity / 2) {
+                        ht__atomic_grow(t);
+                    }
+                    return value;
+                }
+            }
+
+            if(k == key || strcmp(k, key) == 0) {
+                return ht__atomic_wait_value(e);
+            }
+
+            index++;
+            if(index >= t->capacity) {
+                index = 0;
+            }
+        }
+
+        t = ht__atomic_grow(t);
+    }
+    return NULL;
+}
+
+void *ht_atomic_get(AtomicMap *m, const char *key) {
+    uint64_t hash = ht__hash(key);
+    ht__atomic_table *t = m->first;
+
+    while(t != NULL) {
+        size_t index = (size_t)(hash % t->capacity);
+        size_t window = t->capacity < HT_ATOMIC_MAX_PROBE ? t->capacity : HT_ATOMIC_MAX_PROBE;
+
+        for(size_t probe = 0; probe < window; probe++) {
+            ht_atomic_entry *e = &t->ht[index];
+            const char *k = atomic_load_explicit(&e->key, memory_order_acquire);
+
+            // An empty slot in the window means the key never went further
+            if(k == NULL) {
+                return NULL;
+            }
+            if(k == key || strcmp(k, key) == 0) {
+                return ht__atomic_wait_value(e);
+            }
+
+            index++;
+            if(index >= t->capacity) {
+                index = 0;
+            }
+        }
+
+        t = atomic_load_explicit(&t->next, memory_order_acquire);
+    }
+    return NULL;
+}
+
+size_t ht_atomic_length(AtomicMap *m) {
+    return atomic_load_explicit(&m->items, memory_order_relaxed);
+}
+
+void ht_atomic_destroy(AtomicMap *m) {
+    ht__atomic_table *t = m->first;
+    while(t != NULL) {
+        ht__atomic_table *next = atomic_load_explicit(&t->next, memory_order_relaxed);
+        free(t->ht);
+        free(t);
+        t = next;
+    }
+    free(m);
+}
+
+
+// -- Disk-backed map (extendible hashing)
+
+#ifndef HT_DISK_PAGE_SIZE
+#define HT_DISK_PAGE_SIZE 4096
+#endif
+
+#define HT_DISK_MAGIC "HTDISK1"
+#define HT_DISK_MAX_DEPTH 30
+#define HT_DISK_NO_FRAME UINT32_MAX
+
+// Page 0 of the file, the directory is stored after the last bucket
+typedef struct {
+    char magic[8];
+    uint32_t page_size;
+    uint32_t global_depth;
+    uint64_t n_pages;
+    uint64_t items;
+} ht__disk_header;
+
+// Every bucket starts with this, records follow as [klen u16][vlen u16][key][value]
+typedef struct {
+    uint16_t depth;
+    uint16_t count;
+    uint16_t used;
+    uint16_t pad;
+} ht__disk_page;
+
+typedef struct {
+    uint32_t page;
+    int dirty;
+    int referenced;
+    int pinned;
+    char *data;
+} ht__disk_frame;
+
+typedef struct {
+    int fd;
+    uint32_t global_depth;
+    uint32_t *dir;
+    uint64_t n_pages;
+    uint64_t items;
+    ht__disk_frame *frames;
+    size_t n_frames;
+    size_t hand;
+    uint32_t *frame_of;
+    size_t frame_of_cap;
+    char *scratch;
+} DiskMap;
+
+static int ht__disk_write_frame(DiskMap *d, ht__disk_frame *f) {
+    if(f->dirty) {
+        off_t off = (off_t)f->page * HT_DISK_PAGE_SIZE;
+        if(pwrite(d->fd, f->data, HT_DISK_PAGE_SIZE, off) != HT_DISK_PAGE_SIZE) {
+            return -1;
+        }
+        f->dirty = 0;
+    }
+    return 0;
+}
+
+static int ht__disk_track(DiskMap *d, uint64_t pages) {
+    if(pages <= d->frame_of_cap) {
+        return 0;
+    }
+
+    size_t cap = d->frame_of_cap ? d->frame_of_cap : 64;
+    while(cap < pages) {
+        cap *= 2;
+    }
+    uint32_t *frame_of = (uint32_t *)realloc(d->frame_of, cap * sizeof(uint32_t));
+    if(frame_of == NULL) {
+        return -1;
+    }
+    for(size_t i = d->frame_of_cap; i < cap; i++) {
+        frame_of[i] = HT_DISK_NO_FRAME;
+    }
+    d->frame_of = frame_of;
+    d->frame_of_cap = cap;
+    return 0;
+}
+
+// Clock sweep, skipping pinned frames and giving referenced ones a second chance
+static ht__disk_frame *ht__disk_victim(DiskMap *d) {
+    for(size_t sweep = 0; sweep < d->n_frames * 3; sweep++) {
+        ht__disk_frame *f = &d->frames[d->hand];
+        d->hand = (d->hand + 1) % d->n_frames;
+
+        if(f->pinned) {
+            continue;
+        }
+        if(f->page != 0 && f->referenced) {
+            f->referenced = 0;
+            continue;
+        }
+        if(f->page != 0) {
+            if(ht__disk_write_frame(d, f) < 0) {
+                return NULL;
+            }
+            d->frame_of[f->page] = HT_DISK_NO_FRAME;
+        }
+        return f;
+    }
+    return NULL;
+}
+
+// fresh != 0 hands out an empty frame for a page that is not in the file yet
+static char *ht__disk_fetch(DiskMap *d, uint32_t page, int fresh) {
+    uint32_t slot = d->frame_of[page];
+    if(slot != HT_DISK_NO_FRAME) {
+        d->frames[slot].referenced = 1;
+        return d->frames[slot].data;
+    }
+
+    ht__disk_frame *f = ht__disk_victim(d);
+    if(f == NULL) {
+        return NULL;
+    }
+
+    if(fresh) {
+        memset(f->data, 0, HT_DISK_PAGE_SIZE);
+        f->dirty = 1;
+    } else {
+        off_t off = (off_t)page * HT_DISK_PAGE_SIZE;
+        if(pread(d->fd, f->data, HT_DISK_PAGE_SIZE, off) != HT_DISK_PAGE_SIZE) {
+            f->page = 0;
+            return NULL;
+        }
+        f->dirty = 0;
+    }
+
+    f->page = page;
+    f->referenced = 1;
+    d->frame_of[page] = (uint32_t)(f - d->frames);
+    return f->data;
+}
+
+static void ht__disk_pin(DiskMap *d, uint32_t page, int pin) {
+    uint32_t slot = d->frame_of[page];
+    if(slot != HT_DISK_NO_FRAME) {
+        d->frames[slot].pinned = pin;
+    }
+}
+
+static void ht__disk_dirty(DiskMap *d, uint32_t page) {
+    d->frames[d->frame_of[page]].dirty = 1;
+}
+
+static uint16_t ht__disk_u16(const char *p) {
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Offset of key's record in the page, 0 if it isn't there
+static size_t ht__disk_find(const char *page, const char *key, size_t klen) {
+    const ht__disk_page *h = (const ht__disk_page *)page;
+    size_t off = sizeof(ht__disk_page);
+
+    for(uint16_t i = 0; i < h->count; i++) {
+        uint16_t rk = ht__disk_u16(page + off);
+        uint16_t rv = ht__disk_u16(page + off + 2);
+        if(rk == klen && memcmp(page + off + 4, key, klen) == 0) {
+            return off;
+        }
+        off += 4 + rk + rv;
+    }
+    return 0;
+}
+
+static void ht__disk_remove(char *page, size_t off) {
+    ht__disk_page *h = (ht__disk_page *)page;
+    size_t len = 4 + ht__disk_u16(page + off) + ht__disk_u16(page + off + 2);
+    size_t end = sizeof(ht__disk_page) + h->used;
+
+    memmove(page + off, page + off + len, end - off - len);
+    h->used -= (uint16_t)len;
+    h->count--;
+}
+
+static int ht__disk_append(char *page, const char *key, uint16_t klen, const void *value, uint16_t vlen) {
+    ht__disk_page *h = (ht__disk_page *)page;
+    size_t need = 4 + (size_t)klen + vlen;
+    if(sizeof(ht__disk_page) + h->used + need > HT_DISK_PAGE_SIZE) {
+        return -1;
+    }
+
+    char *dst = page + sizeof(ht__disk_page) + h->used;
+    memcpy(dst, &klen, 2);
+    memcpy(dst + 2, &vlen, 2);
+    memcpy(dst + 4, key, klen);
+    memcpy(dst + 4 + klen, value, vlen);
+    h->used += (uint16_t)need;
+    h->count++;
+    return 0;
+}
+
+static uint32_t ht__disk_bucket(DiskMap *d, uint64_t hash) {
+    return d->dir[hash & ((1ULL << d->global_depth) - 1)];
+}
+
+static int ht__disk_split(DiskMap *d, uint32_t page) {
+    char *old = ht__disk_fetch(d, page, 0);
+    if(old == NULL) {
+        return -1;
+    }
+
+    uint16_t depth = ((ht__disk_page *)old)->depth;
+    if(depth >= HT_DISK_MAX_DEPTH) {
+        return -1;
+    }
+
+    if(depth == d->global_depth) {
+        size_t n = (size_t)1 << d->global_depth;
+        uint32_t *dir = (uint32_t *)realloc(d->dir, 2 * n * sizeof(uint32_t));
+        if(dir == NULL) {
+            return -1;
+        }
+        memcpy(dir + n, dir, n * sizeof(uint32_t));
+        d->dir = dir;
+        d->global_depth++;
+    }
+
+    if(d->n_pages >= UINT32_MAX || ht__disk_track(d, d->n_pages + 1) < 0) {
+        return -1;
+    }
+    uint32_t sibling = (uint32_t)d->n_pages;
+
+    memcpy(d->scratch, old, HT_DISK_PAGE_SIZE);
+    ht__disk_pin(d, page, 1);
+    char *fresh = ht__disk_fetch(d, sibling, 1);
+    ht__disk_pin(d, page, 0);
+    if(fresh == NULL) {
+        return -1;
+    }
+    d->n_pages++;
+
+    memset(old, 0, HT_DISK_PAGE_SIZE);
+    ((ht__disk_page *)old)->depth = depth + 1;
+    ((ht__disk_page *)fresh)->depth = depth + 1;
+
+    // Records whose hash has bit `depth` set move to the sibling
+    const ht__disk_page *h = (const ht__disk_page *)d->scratch;
+    size_t off = sizeof(ht__disk_page);
+    for(uint16_t i = 0; i < h->count; i++) {
+        uint16_t rk = ht__disk_u16(d->scratch + off);
+        uint16_t rv = ht__disk_u16(d->scratch + off + 2);
+        const char *key = d->scratch + off + 4;
+        char *dst = ((ht__hash_n(key, rk) >> depth) & 1) ? fresh : old;
+        ht__disk_append(dst, key, rk, key + rk, rv);
+        off += 4 + rk + rv;
+    }
+
+    size_t n = (size_t)1 << d->global_depth;
+    for(size_t i = 0; i < n; i++) {
+        if(d->dir[i] == page && ((i >> depth) & 1)) {
+            d->dir[i] = sibling;
+        }
+    }
+
+    ht__disk_dirty(d, page);
+    return 0;
+}
+
+int ht_disk_sync(DiskMap *d) {
+    for(size_t i = 0; i < d->n_frames; i++) {
+        if(d->frames[i].page != 0 && ht__disk_write_frame(d, &d->frames[i]) < 0) {
+            return -1;
+        }
+    }
+
+    size_t dir_bytes = ((size_t)1 << d->global_depth) * sizeof(uint32_t);
+    off_t dir_off = (off_t)d->n_pages * HT_DISK_PAGE_SIZE;
+    if(pwrite(d->fd, d->dir, dir_bytes, dir_off) != (ssize_t)dir_bytes) {
+        return -1;
+    }
+
+    ht__disk_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, HT_DISK_MAGIC, sizeof(HT_DISK_MAGIC));
+    hdr.page_size = HT_DISK_PAGE_SIZE;
+    hdr.global_depth = d->global_depth;
+    hdr.n_pages = d->n_pages;
+    hdr.items = d->items;
+    if(pwrite(d->fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+        return -1;
+    }
+
+    if(ftruncate(d->fd, dir_off + (off_t)dir_bytes) < 0) {
+        return -1;
+    }
+    return fdatasync(d->fd);
+}
+
+static void ht__disk_free(DiskMap *d) {
+    if(d->frames) {
+        for(size_t i = 0; i < d->n_frames; i++) {
+            free(d->frames[i].data);
+        }
+    }
+    if(d->fd >= 0) {
+        close(d->fd);
+    }
+    free(d->frames);
+    free(d->frame_of);
+    free(d->dir);
+    free(d->scratch);
+    free(d);
+}
+
+DiskMap *ht_disk_open(const char *path, size_t pool_pages) {
+    DiskMap *d = (DiskMap *)calloc(1, sizeof(DiskMap));
+    if(d == NULL) {
+        return NULL;
+    }
+
+    d->fd = open(path, O_RDWR | O_CREAT, 0644);
+    d->n_frames = pool_pages < 2 ? 2 : pool_pages;
+    d->frames = (ht__disk_frame *)calloc(d->n_frames, sizeof(ht__disk_frame));
+    d->scratch = (char *)malloc(HT_DISK_PAGE_SIZE);
+    if(d->fd < 0 || d->frames == NULL || d->scratch == NULL) {
+        ht__disk_free(d);
+        return NULL;
+    }
+    for(size_t i = 0; i < d->n_frames; i++) {
+        d->frames[i].data = (char *)malloc(HT_DISK_PAGE_SIZE);
+        if(d->frames[i].data == NULL) {
+            ht__disk_free(d);
+            return NULL;
+        }
+    }
+
+    ht__disk_header hdr;
+    ssize_t got = pread(d->fd, &hdr, sizeof(hdr), 0);
+
+    if(got == 0) {
+        // New file: depth 0, one empty bucket in page 1
+        d->global_depth = 0;
+        d->n_pages = 2;
+        d->dir = (uint32_t *)malloc(sizeof(uint32_t));
+        if(d->dir == NULL || ht__disk_track(d, d->n_pages) < 0 || ht__disk_fetch(d, 1, 1) == NULL) {
+            ht__disk_free(d);
+            return NULL;
+        }
+        d->dir[0] = 1;
+        if(ht_disk_sync(d) < 0) {
+            ht__disk_free(d);
+            return NULL;
+        }
+        return d;
+    }
+
+    if(got != sizeof(hdr) || memcmp(hdr.magic, HT_DISK_MAGIC, sizeof(HT_DISK_MAGIC)) != 0
+       || hdr.page_size != HT_DISK_PAGE_SIZE || hdr.global_depth > HT_DISK_MAX_DEPTH) {
+        ht__disk_free(d);
+        return NULL;
+    }
+
+    d->global_depth = hdr.global_depth;
+    d->n_pages = hdr.n_pages;
+    d->items = hdr.items;
+
+    size_t dir_bytes = ((size_t)1 << d->global_depth) * sizeof(uint32_t);
+    d->dir = (uint32_t *)malloc(dir_bytes);
+    if(d->dir == NULL || ht__disk_track(d, d->n_pages) < 0
+       || pread(d->fd, d->dir, dir_bytes, (off_t)d->n_pages * HT_DISK_PAGE_SIZE) != (ssize_t)dir_bytes) {
+        ht__disk_free(d);
+        return NULL;
+    }
+    return d;
+}
+
+const void *ht_disk_get(DiskMap *d, const char *key, size_t *len) {
+    size_t klen = strlen(key);
+    char *page = ht__disk_fetch(d, ht__disk_bucket(d, ht__hash_n(key, klen)), 0);
+    if(page == NULL) {
+        return NULL;
+    }
+
+    size_t off = ht__disk_find(page, key, klen);
+    if(off == 0) {
+        return NULL;
+    }
+
+    if(len) *len = ht__disk_u16(page + off + 2);
+    return page + off + 4 + klen;
+}
+
+int ht_disk_set(DiskMap *d, const char *key, const void *value, size_t len) {
+    size_t klen = strlen(key);
+    if(4 + klen + len > HT_DISK_PAGE_SIZE - sizeof(ht__disk_page)) {
+        return -1;
+    }
+
+    uint64_t hash = ht__hash_n(key, klen);
+
+    for(;;) {
+        uint32_t bucket = ht__disk_bucket(d, hash);
+        char *page = ht__disk_fetch(d, bucket, 0);
+        if(page == NULL) {
+            return -1;
+        }
+
+        // Only drop the old record once the new one is known to fit
+        size_t off = ht__disk_find(page, key, klen);
+        size_t old_len = off ? 4 + klen + ht__disk_u16(page + off + 2) : 0;
+        size_t used = ((ht__disk_page *)page)->used - old_len;
+
+        if(sizeof(ht__disk_page) + used + 4 + klen + len <= HT_DISK_PAGE_SIZE) {
+            if(off != 0) {
+                ht__disk_remove(page, off);
+            } else {
+                d->items++;
+            }
+            ht__disk_append(page, key, (uint16_t)klen, value, (uint16_t)len);
+            ht__disk_dirty(d, bucket);
+            return 0;
+        }
+
+        if(ht__disk_split(d, bucket) < 0) {
+            return -1;
+        }
+    }
+}
+
+int ht_disk_delete(DiskMap *d, const char *key) {
+    size_t klen = strlen(key);
+    uint32_t bucket = ht__disk_bucket(d, ht__hash_n(key, klen));
+    char *page = ht__disk_fetch(d, bucket, 0);
+    if(page == NULL) {
+        return -1;
+    }
+
+    size_t off = ht__disk_find(page, key, klen);
+    if(off == 0) {
+        return -1;
+    }
+
+    ht__disk_remove(page, off);
+    ht__disk_dirty(d, bucket);
+    d->items--;
+    return 0;
+}
+
+size_t ht_disk_length(DiskMap *d) {
+    return (size_t)d->items;
+}
+
+int ht_disk_close(DiskMap *d) {
+    int result = ht_disk_sync(d);
+    ht__disk_free(d);
+    return result;
+}
+
+
+// -- Durable map (write-ahead log + snapshots)
+
+#ifndef HT_WAL_BATCH_BYTES
+#define HT_WAL_BATCH_BYTES (1 << 20)
+#endif
+
+#define HT_SNAP_MAGIC "HTSNAP1"
+#define HT_WAL_SET 1
+#define HT_WAL_DELETE 2
+
+// Log record: [check u32][op u8][klen u32][vlen u32][key][value], check is
+// the low half of FNV-1a over everything after it
+#define HT_WAL_HEADER 13
+
+typedef struct {
+    uint32_t len;
+    char data[];
+} ht_blob;
+
+typedef struct {
+    Map *map;
+    char *wal_path;
+    char *snap_path;
+    char *dir;
+    int wal_fd;
+    char *buf;
+    size_t buf_len;
+    size_t buf_cap;
+    char *spare;
+    size_t spare_cap;
+    uint64_t appended;
+    uint64_t durable;
+    int flushing;
+    int failed;
+    pthread_mutex_t lock;
+    pthread_cond_t flushed;
+    char *snap;
+    size_t snap_size;
+} DurableMap;
+
+static int ht__durable_in_snap(DurableMap *d, const void *p) {
+    return d->snap != NULL && (const char *)p >= d->snap && (const char *)p < d->snap + d->snap_size;
+}
+
+static void ht__durable_drop(DurableMap *d, const char *key, void *value) {
+    if(!ht__durable_in_snap(d, key)) free((void *)key);
+    if(!ht__durable_in_snap(d, value)) free(value);
+}
+
+// Returns -1 and leaves the map as it was if memory runs out
+static int ht__durable_apply_set(DurableMap *d, const char *key, size_t klen, const void *value, size_t vlen) {
+    ht_blob *blob = (ht_blob *)malloc(sizeof(ht_blob) + vlen);
+    if(blob == NULL) {
+        return -1;
+    }
+    blob->len = (uint32_t)vlen;
+    memcpy(blob->data, value, vlen);
+
+    // The stored key stays the first one, only the value is swapped
+    void *old = ht_get(d->map, key);
+    if(old != NULL) {
+        if(ht_set(d->map, key, blob) == NULL) {
+            free(blob);
+            return -1;
+        }
+        if(!ht__durable_in_snap(d, old)) free(old);
+        return 0;
+    }
+
+    char *copy = (char *)malloc(klen + 1);
+    if(copy == NULL) {
+        free(blob);
+        return -1;
+    }
+    memcpy(copy, key, klen);
+    copy[klen] = '\0';
+    if(ht_set(d->map, copy, blob) == NULL) {
+        free(copy);
+        free(blob);
+        return -1;
+    }
+    return 0;
+}
+
+static int ht__durable_apply_delete(DurableMap *d, const char *key) {
+    size_t index = (size_t)(ht__hash(key) % d->map->capacity);
+    while(d->map->ht[index].value != NULL && strcmp(d->map->ht[index].key, key) != 0) {
+        index = index + 1 < d->map->capacity ? index + 1 : 0;
+    }
+
+    const char *stored = d->map->ht[index].key;
+    void *value = ht_delete(d->map, key);
+    if(value == NULL) {
+        return -1;
+    }
+    ht__durable_drop(d, stored, value);
+    return 0;
+}
+
+static int ht__durable_append(DurableMap *d, uint8_t op, const char *key, uint32_t klen,
+                              const void *value, uint32_t vlen) {
+    size_t need = HT_WAL_HEADER + (size_t)klen + vlen;
+    if(d->buf_len + need > d->buf_cap) {
+        size_t cap = d->buf_cap ? d->buf_cap : 4096;
+        while(cap < d->buf_len + need) {
+            cap *= 2;
+        }
+        char *buf = (char *)realloc(d->buf, cap);
+        if(buf == NULL) {
+            return -1;
+        }
+        d->buf = buf;
+        d->buf_cap = cap;
+    }
+
+    char *r = d->buf + d->buf_len;
+    r[4] = (char)op;
+    memcpy(r + 5, &klen, 4);
+    memcpy(r + 9, &vlen, 4);
+    memcpy(r + HT_WAL_HEADER, key, klen);
+    if(vlen) memcpy(r + HT_WAL_HEADER + klen, value, vlen);
+
+    uint32_t check = (uint32_t)ht__hash_n(r + 4, need - 4);
+    memcpy(r, &check, 4);
+
+    d->buf_len += need;
+    d->appended++;
+    return 0;
+}
+
+static int ht__durable_write_all(int fd, const char *p, size_t len) {
+    while(len > 0) {
+        ssize_t n = write(fd, p, len);
+        if(n < 0) {
+            if(errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Caller holds d->lock. One thread at a time becomes the leader, takes the
+// whole buffer and syncs it while the others keep appending to a fresh one
+static int ht__durable_commit_locked(DurableMap *d) {
+    uint64_t target = d->appended;
+
+    while(d->durable < target && !d->failed) {
+        if(d->flushing) {
+            pthread_cond_wait(&d->flushed, &d->lock);
+            continue;
+        }
+
+        char *buf = d->buf;
+        size_t len = d->buf_len;
+        size_t cap = d->buf_cap;
+        uint64_t upto = d->appended;
+
+        d->buf = d->spare;
+        d->buf_cap = d->spare_cap;
+        d->buf_len = 0;
+        d->spare = NULL;
+        d->spare_cap = 0;
+        d->flushing = 1;
+        pthread_mutex_unlock(&d->lock);
+
+        int ok = ht__durable_write_all(d->wal_fd, buf, len) == 0 && fdatasync(d->wal_fd) == 0;
+
+        pthread_mutex_lock(&d->lock);
+        d->spare = buf;
+        d->spare_cap = cap;
+        d->flushing = 0;
+        if(ok) {
+            d->durable = upto;
+        } else {
+            d->failed = 1;
+        }
+        pthread_cond_broadcast(&d->flushed);
+    }
+
+    return d->failed ? -1 : 0;
+}
+
+int ht_durable_commit(DurableMap *d) {
+    pthread_mutex_lock(&d->lock);
+    int result = ht__durable_commit_locked(d);
+    pthread_mutex_unlock(&d->lock);
+    return result;
+}
+
+int ht_durable_set(DurableMap *d, const char *key, const void *value, size_t len) {
+    size_t klen = strlen(key);
+    if(klen > UINT32_MAX || len > UINT32_MAX) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&d->lock);
+    int result = ht__durable_append(d, HT_WAL_SET, key, (uint32_t)klen, value, (uint32_t)len);
+    if(result == 0 && ht__durable_apply_set(d, key, klen, value, len) < 0) {
+        // Still the last record in the buffer, take it back out of the log
+        d->buf_len -= HT_WAL_HEADER + klen + len;
+        d->appended--;
+        result = -1;
+    }
+    if(result == 0) {
+        if(d->buf_len >= HT_WAL_BATCH_BYTES) {
+            result = ht__durable_commit_locked(d);
+        }
+    }
+    pthread_mutex_unlock(&d->lock);
+    return result;
+}
+
+int ht_durable_delete(DurableMap *d, const char *key) {
+    size_t klen = strlen(key);
+    if(klen > UINT32_MAX) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&d->lock);
+    int result = -1;
+    if(ht_get(d->map, key) != NULL) {
+        result = ht__durable_append(d, HT_WAL_DELETE, key, (uint32_t)klen, NULL, 0);
+        if(result == 0) {
+            ht__durable_apply_delete(d, key);
+            if(d->buf_len >= HT_WAL_BATCH_BYTES) {
+                result = ht__durable_commit_locked(d);
+            }
+        }
+    }
+    pthread_mutex_unlock(&d->lock);
+    return result;
+}
+
+const void *ht_durable_get(DurableMap *d, const char *key, size_t *len) {
+    pthread_mutex_lock(&d->lock);
+    ht_blob *blob = (ht_blob *)ht_get(d->map, key);
+    pthread_mutex_unlock(&d->lock);
+
+    if(blob == NULL) {
+        return NULL;
+    }
+    if(len) *len = blob->len;
+    return blob->data;
+}
+
+size_t ht_durable_length(DurableMap *d) {
+    pthread_mutex_lock(&d->lock);
+    size_t n = ht_length(d->map);
+    pthread_mutex_unlock(&d->lock);
+    return n;
+}
+
+// Snapshot: [magic 8][count u64] then per item, 4-byte aligned,
+// [klen u32][key NUL pad][vlen u32][value pad] so keys and ht_blob values
+// can be used in place from the mapping
+static size_t ht__durable_pad(size_t n) {
+    return (n + 3) & ~(size_t)3;
+}
+
+// Indexes the mapped snapshot, NULL if memory runs out or the file is
+// truncated or corrupt: every length is checked against the mapping
+// before anything behind it is read
+static Map *ht__durable_map_snapshot(DurableMap *d) {
+    Map *m = ht_new_map(64);
+    if(m == NULL || d->snap == NULL) {
+        return m;
+    }
+
+    uint64_t count;
+    memcpy(&count, d->snap + 8, sizeof(count));
+
+    size_t size = d->snap_size;
+    size_t off = 16;
+    for(uint64_t i = 0; i < count; i++) {
+        uint32_t klen;
+        if(off > size || size - off < 4) {
+            goto corrupt;
+        }
+        memcpy(&klen, d->snap + off, 4);
+        const char *key = d->snap + off + 4;
+        if(size - off - 4 < (size_t)klen + 1 || key[klen] != '\0' || memchr(key, '\0', klen) != NULL) {
+            goto corrupt;
+        }
+        off += ht__durable_pad(4 + (size_t)klen + 1);
+
+        if(off > size || size - off < 4) {
+            goto corrupt;
+        }
+        ht_blob *blob = (ht_blob *)(d->snap + off);
+        if(size - off - 4 < (size_t)blob->len) {
+            goto corrupt;
+        }
+        off += ht__durable_pad(4 + (size_t)blob->len);
+
+        if(ht_set(m, key, blob) == NULL) {
+            goto corrupt;
+        }
+    }
+
+    // The writer pads every item, so the last one ends the file
+    if(off == size) {
+        return m;
+    }
+
+corrupt:
+    ht_free(m);
+    return NULL;
+}
+
+static int ht__durable_open_snapshot(DurableMap *d) {
+    int fd = open(d->snap_path, O_RDONLY);
+    if(fd < 0) {
+        return errno == ENOENT ? 0 : -1;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) < 0 || st.st_size < 16) {
+        close(fd);
+        return -1;
+    }
+
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED) {
+        return -1;
+    }
+    if(memcmp(p, HT_SNAP_MAGIC, sizeof(HT_SNAP_MAGIC)) != 0) {
+        munmap(p, (size_t)st.st_size);
+        return -1;
+    }
+
+    d->snap = (char *)p;
+    d->snap_size = (size_t)st.st_size;
+    return 0;
+}
+
+// Applies every intact record of the log, returns where the valid part ends
+static off_t ht__durable_replay(DurableMap *d) {
+    struct stat st;
+    if(fstat(d->wal_fd, &st) < 0 || st.st_size == 0) {
+        return 0;
+    }
+
+    size_t size = (size_t)st.st_size;
+    char *log = (char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, d->wal_fd, 0);
+    if(log == MAP_FAILED) {
+        return -1;
+    }
+
+    size_t off = 0;
+    while(off + HT_WAL_HEADER <= size) {
+        uint32_t check, klen, vlen;
+        memcpy(&check, log + off, 4);
+        memcpy(&klen, log + off + 5, 4);
+        memcpy(&vlen, log + off + 9, 4);
+
+        size_t len = HT_WAL_HEADER + (size_t)klen + vlen;
+        if(len > size - off || (uint32_t)ht__hash_n(log + off + 4, len - 4) != check) {
+            break;
+        }
+
+        // Keys in the log are not NUL terminated
+        char *key = (char *)malloc((size_t)klen + 1);
+        if(key == NULL) {
+            munmap(log, size);
+            return -1;
+        }
+        memcpy(key, log + off + HT_WAL_HEADER, klen);
+        key[klen] = '\0';
+
+        int applied = 0;
+        if(log[off + 4] == HT_WAL_SET) {
+            applied = ht__durable_apply_set(d, key, klen, log + off + HT_WAL_HEADER + klen, vlen);
+        } else if(log[off + 4] == HT_WAL_DELETE) {
+            ht__durable_apply_delete(d, key);
+        }
+        free(key);
+        if(applied < 0) {
+            munmap(log, size);
+            return -1;
+        }
+        off += len;
+    }
+
+    munmap(log, size);
+    return (off_t)off;
+}
+
+static void ht__durable_free(DurableMap *d) {
+    if(d->map) {
+        for(size_t i = 0; i < d->map->capacity; i++) {
+            if(d->map->ht[i].value != NULL) {
+                ht__durable_drop(d, d->map->ht[i].key, d->map->ht[i].value);
+            }
+        }
+        ht_free(d->map);
+    }
+    if(d->snap) munmap(d->snap, d->snap_size);
+    if(d->wal_fd >= 0) close(d->wal_fd);
+    pthread_mutex_destroy(&d->lock);
+    pthread_cond_destroy(&d->flushed);
+    free(d->buf);
+    free(d->spare);
+    free(d->wal_path);
+    free(d->snap_path);
+    free(d->dir);
+    free(d);
+}
+
+static char *ht__durable_path(const char *dir, const char *name) {
+    size_t len = strlen(dir) + strlen(name) + 2;
+    char *path = (char *)malloc(len);
+    if(path == NULL) {
+        return NULL;
+    }
+    snprintf(path, len, "%s/%s", dir, name);
+    return path;
+}
+
+DurableMap *ht_durable_open(const char *dir) {
+    if(mkdir(dir, 0755) < 0 && errno != EEXIST) {
+        return NULL;
+    }
+
+    DurableMap *d = (DurableMap *)calloc(1, sizeof(DurableMap));
+    if(d == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&d->lock, NULL);
+    pthread_cond_init(&d->flushed, NULL);
+    d->wal_fd = -1;
+    d->dir = strdup(dir);
+    d->wal_path = ht__durable_path(dir, "wal");
+    d->snap_path = ht__durable_path(dir, "snapshot");
+    if(d->dir == NULL || d->wal_path == NULL || d->snap_path == NULL) {
+        ht__durable_free(d);
+        return NULL;
+    }
+
+    if(ht__durable_open_snapshot(d) < 0) {
+        ht__durable_free(d);
+        return NULL;
+    }
+    d->map = ht__durable_map_snapshot(d);
+    if(d->map == NULL) {
+        ht__durable_free(d);
+        return NULL;
+    }
+
+    d->wal_fd = open(d->wal_path, O_RDWR | O_CREAT, 0644);
+    if(d->wal_fd < 0) {
+        ht__durable_free(d);
+        return NULL;
+    }
+
+    off_t valid = ht__durable_replay(d);
+    if(valid < 0 || ftruncate(d->wal_fd, valid) < 0 || lseek(d->wal_fd, valid, SEEK_SET) < 0) {
+        ht__durable_free(d);
+        return NULL;
+    }
+    return d;
+}
+
+static int ht__durable_write_snapshot(DurableMap *d, const char *path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) {
+        return -1;
+    }
+
+    size_t cap = 1 << 16, len = 0;
+    char *out = (char *)malloc(cap);
+    if(out == NULL) {
+        close(fd);
+        return -1;
+    }
+    uint64_t count = ht_length(d->map);
+    memset(out, 0, 16);
+    memcpy(out, HT_SNAP_MAGIC, sizeof(HT_SNAP_MAGIC));
+    memcpy(out + 8, &count, sizeof(count));
+    len = 16;
+
+    int ok = 1;
+    for(size_t i = 0; i < d->map->capacity && ok; i++) {
+        ht_entry *e = &d->map->ht[i];
+        if(e->value == NULL) {
+            continue;
+        }
+
+        ht_blob *blob = (ht_blob *)e->value;
+        uint32_t klen = (uint32_t)strlen(e->key);
+        size_t kpart = ht__durable_pad(4 + (size_t)klen + 1);
+        size_t vpart = ht__durable_pad(4 + (size_t)blob->len);
+
+        if(len + kpart + vpart > cap) {
+            ok = ht__durable_write_all(fd, out, len) == 0;
+            len = 0;
+            if(kpart + vpart > cap) {
+                char *grown = (char *)realloc(out, kpart + vpart);
+                if(grown == NULL) {
+                    ok = 0;
+                    break;
+                }
+                out = grown;
+                cap = kpart + vpart;
+            }
+        }
+
+        memset(out + len, 0, kpart + vpart);
+        memcpy(out + len, &klen, 4);
+        memcpy(out + len + 4, e->key, klen);
+        memcpy(out + len + kpart, blob, 4 + (size_t)blob->len);
+        len += kpart + vpart;
+    }
+
+    ok = ok && ht__durable_write_all(fd, out, len) == 0 && fdatasync(fd) == 0;
+    free(out);
+    close(fd);
+    return ok ? 0 : -1;
+}
+
+int ht_durable_checkpoint(DurableMap *d) {
+    pthread_mutex_lock(&d->lock);
+    // The commit can return while another thread leads a flush outside the
+    // lock; truncating under its write would leave a hole in the log that
+    // recovery stops at. Holding the lock with no leader keeps new ones out
+    int committed = ht__durable_commit_locked(d);
+    while(committed == 0 && (d->flushing || d->appended > d->durable)) {
+        while(d->flushing) {
+            pthread_cond_wait(&d->flushed, &d->lock);
+        }
+        committed = ht__durable_commit_locked(d);
+    }
+    if(committed < 0) {
+        pthread_mutex_unlock(&d->lock);
+        return -1;
+    }
+
+    char *tmp = ht__durable_path(d->dir, "snapshot.tmp");
+    int result = tmp != NULL ? ht__durable_write_snapshot(d, tmp) : -1;
+    if(result == 0 && rename(tmp, d->snap_path) < 0) {
+        result = -1;
+    }
+    free(tmp);
+
+    if(result == 0) {
+        int dfd = open(d->dir, O_RDONLY);
+        if(dfd >= 0) {
+            fsync(dfd);
+            close(dfd);
+        }
+
+        // The snapshot covers the whole log now; replaying it again after a
+        // crash right here would be harmless, set/delete are idempotent
+        if(ftruncate(d->wal_fd, 0) < 0 || lseek(d->wal_fd, 0, SEEK_SET) < 0 || fdatasync(d->wal_fd) < 0) {
+            result = -1;
+        }
+    }
+
+    if(result == 0) {
+        // Rebuild the map over the new snapshot so the heap copies go away
+        Map *old = d->map;
+        char *old_snap = d->snap;
+        size_t old_size = d->snap_size;
+
+        d->snap = NULL;
+        Map *fresh = NULL;
+        if(ht__durable_open_snapshot(d) == 0) {
+            fresh = ht__durable_map_snapshot(d);
+            if(fresh == NULL && d->snap != NULL) {
+                munmap(d->snap, d->snap_size);
+            }
+        }
+        if(fresh != NULL) {
+            d->map = fresh;
+
+            char *new_snap = d->snap;
+            size_t new_size = d->snap_size;
+            d->snap = old_snap;
+            d->snap_size = old_size;
+            for(size_t i = 0; i < old->capacity; i++) {
+                if(old->ht[i].value != NULL) {
+                    ht__durable_drop(d, old->ht[i].key, old->ht[i].value);
+                }
+            }
+            ht_free(old);
+            if(old_snap) munmap(old_snap, old_size);
+
+            d->snap = new_snap;
+            d->snap_size = new_size;
+        } else {
+            // Keep serving from the heap copies and the old mapping
+            d->snap = old_snap;
+            d->snap_size = old_size;
+        }
+    }
+
+    pthread_mutex_unlock(&d->lock);
+    return result;
+}
+
+int ht_durable_close(DurableMap *d) {
+    int result = ht_durable_commit(d);
+    ht__durable_free(d);
+    return result;
+}
+
+
+// -- Compact map (32-bit offsets + fingerprints)
+
+typedef struct {
+    uint32_t off;
+    uint16_t fp;
+    uint16_t len;
+} ht_compact_slot;
+
+// Arena records are [void *value][key NUL] padded to 8 bytes, slot offsets
+// count 8-byte units plus one so that 0 marks an empty slot
+typedef struct {
+    ht_compact_slot *ht;
+    size_t capacity;
+    size_t items;
+    char *arena;
+    size_t arena_len;
+    size_t arena_cap;
+} CompactMap;
+
+static uint16_t ht__fingerprint(uint64_t hash) {
+    return (uint16_t)(hash >> 48);
+}
+
+static char *ht__compact_record(CompactMap *m, ht_compact_slot *slot) {
+    return m->arena + ((size_t)(slot->off - 1) << 3);
+}
+
+CompactMap *ht_compact_new(size_t capacity) {
+    CompactMap *m = (CompactMap *)malloc(sizeof(CompactMap));
+    if(m == NULL) {
+        return NULL;
+    }
+
+    m->capacity = capacity > 0 ? capacity : 16;
+    m->ht = (ht_compact_slot *)calloc(m->capacity, sizeof(ht_compact_slot));
+    m->items = 0;
+    m->arena = NULL;
+    m->arena_len = 0;
+    m->arena_cap = 0;
+    if(m->ht == NULL) {
+        free(m);
+        return NULL;
+    }
+    return m;
+}
+
+static ht_compact_slot *ht__compact_find(CompactMap *m, const char *key, size_t len, uint64_t hash) {
+    size_t index = (size_t)(hash % m->capacity);
+    uint16_t fp = ht__fingerprint(hash);
+
+    while(m->ht[index].off != 0) {
+        ht_compact_slot *slot = &m->ht[index];
+        if(slot->fp == fp && slot->len == len
+           && memcmp(ht__compact_record(m, slot) + sizeof(void *), key, len) == 0) {
+            return slot;
+        }
+        index++;
+        if(index >= m->capacity) {
+            index = 0;
+        }
+    }
+    return &m->ht[index];
+}
+
+static int ht__compact_expand(CompactMap *m) {
+    size_t new_cap = m->capacity * 2;
+    ht_compact_slot *slots = (ht_compact_slot *)calloc(new_cap, sizeof(ht_compact_slot));
+    if(slots == NULL) {
+        return -1;
+    }
+
+    for(size_t i = 0; i < m->capacity; i++) {
+        ht_compact_slot *slot = &m->ht[i];
+        if(slot->off == 0) {
+            continue;
+        }
+
+        // Slots keep no full hash, rehash the key from the arena
+        const char *key = ht__compact_record(m, slot) + sizeof(void *);
+        size_t index = (size_t)(ht__hash_n(key, slot->len) % new_cap);
+        while(slots[index].off != 0) {
+            index = index + 1 < new_cap ? index + 1 : 0;
+        }
+        slots[index] = *slot;
+    }
+
+    free(m->ht);
+    m->ht = slots;
+    m->capacity = new_cap;
+    return 0;
+}
+
+int ht_compact_set(CompactMap *m, const char *key, void *value) {
+    if(key == NULL || value == NULL) {
+        return -1;
+    }
+
+    size_t len = strlen(key);
+    if(len > UINT16_MAX) {
+        return -1;
+    }
+
+    if(m->items >= m->capacity / 2 && ht__compact_expand(m) < 0) {
+        return -1;
+    }
+
+    uint64_t hash = ht__hash_n(key, len);
+    ht_compact_slot *slot = ht__compact_find(m, key, len, hash);
+    if(slot->off != 0) {
+        memcpy(ht__compact_record(m, slot), &value, sizeof(void *));
+        return 0;
+    }
+
+    size_t need = (sizeof(void *) + len + 1 + 7) & ~(size_t)7;
+    if((m->arena_len >> 3) + 1 > UINT32_MAX) {
+        return -1;
+    }
+    if(m->arena_len + need > m->arena_cap) {
+        size_t cap = m->arena_cap ? m->arena_cap * 2 : 4096;
+        while(cap < m->arena_len + need) {
+            cap *= 2;
+        }
+        char *arena = (char *)realloc(m->arena, cap);
+        if(arena == NULL) {
+            return -1;
+        }
+        m->arena = arena;
+        m->arena_cap = cap;
+    }
+
+    char *record = m->arena + m->arena_len;
+    memcpy(record, &value, sizeof(void *));
+    memcpy(record + sizeof(void *), key, len + 1);
+
+    slot->off = (uint32_t)((m->arena_len >> 3) + 1);
+    slot->fp = ht__fingerprint(hash);
+    slot->len = (uint16_t)len;
+    m->arena_len += need;
+    m->items++;
+    return 0;
+}
+
+void *ht_compact_get(CompactMap *m, const char *key) {
+    size_t len = strlen(key);
+    if(len > UINT16_MAX) {
+        return NULL;
+    }
+
+    ht_compact_slot *slot = ht__compact_find(m, key, len, ht__hash_n(key, len));
+    if(slot->off == 0) {
+        return NULL;
+    }
+
+    void *value;
+    memcpy(&value, ht__compact_record(m, slot), sizeof(void *));
+    return value;
+}
+
+size_t ht_compact_length(CompactMap *m) {
+    return m->items;
+}
+
+void ht_compact_destroy(CompactMap *m) {
+    free(m->ht);
+    free(m->arena);
+    free(m);
+}
+
+
+// -- Inline (small key) map
+
+#ifndef HT_INLINE_KEY_MAX
+#define HT_INLINE_KEY_MAX 15
+#endif
+
+typedef struct {
+    void *value;
+    uint32_t hash;
+    uint32_t len;
+    union {
+        char small[HT_INLINE_KEY_MAX + 1];
+        const char *big;
+    } key;
+} ht_inline_entry;
+
+typedef struct {
+    ht_inline_entry *ht;
+    size_t capacity;
+    size_t items;
+} InlineMap;
+
+// Slots keep 32 bits of the hash, enough to index and to skip most
+// mismatches, and expands never have to look at the keys again
+static uint32_t ht__inline_hash(const char *key, size_t len) {
+    uint64_t hash = ht__hash_n(key, len);
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+static const char *ht__inline_key(const ht_inline_entry *e) {
+    return e->len <= HT_INLINE_KEY_MAX ? e->key.small : e->key.big;
+}
+
+static ht_inline_entry *ht__inline_alloc(size_t capacity) {
+    void *p = NULL;
+    if(posix_memalign(&p, 64, capacity * sizeof(ht_inline_entry)) != 0) {
+        return NULL;
+    }
+    memset(p, 0, capacity * sizeof(ht_inline_entry));
+    return (ht_inline_entry *)p;
+}
+
+InlineMap *ht_inline_new(size_t capacity) {
+    InlineMap *m = (InlineMap *)malloc(sizeof(InlineMap));
+    if(m == NULL) {
+        return NULL;
+    }
+
+    m->capacity = capacity > 0 ? capacity : 16;
+    m->items = 0;
+    m->ht = ht__inline_alloc(m->capacity);
+    if(m->ht == NULL) {
+        free(m);
+        return NULL;
+    }
+    return m;
+}
+
+static ht_inline_entry *ht__inline_find(InlineMap *m, const char *key, size_t len, uint32_t hash) {
+    size_t index = hash % m->capacity;
+
+    while(m->ht[index].value != NULL) {
+        ht_inline_entry *e = &m->ht[index];
+        if(e->hash == hash && e->len == len && memcmp(ht__inline_key(e), key, len) == 0) {
+            return e;
+        }
+        index++;
+        if(index >= m->capacity) {
+            index = 0;
+        }
+    }
+    return &m->ht[index];
+}
+
+static int ht__inline_expand(InlineMap *m) {
+    size_t new_cap = m->capacity * 2;
+    ht_inline_entry *entries = ht__inline_alloc(new_cap);
+    if(entries == NULL) {
+        return -1;
+    }
+
+    for(size_t i = 0; i < m->capacity; i++) {
+        if(m->ht[i].value == NULL) {
+            continue;
+        }
+        size_t index = m->ht[i].hash % new_cap;
+        while(entries[index].value != NULL) {
+            index = index + 1 < new_cap ? index + 1 : 0;
+        }
+        entries[index] = m->ht[i];
+    }
+
+    free(m->ht);
+    m->ht = entries;
+    m->capacity = new_cap;
+    return 0;
+}
+
+int ht_inline_set(InlineMap *m, const char *key, void *value) {
+    if(key == NULL || value == NULL) {
+        return -1;
+    }
+
+    size_t len = strlen(key);
+    if(len > UINT32_MAX) {
+        return -1;
+    }
+
+    if(m->items >= m->capacity / 2 && ht__inline_expand(m) < 0) {
+        return -1;
+    }
+
+    uint32_t hash = ht__inline_hash(key, len);
+    ht_inline_entry *e = ht__inline_find(m, key, len, hash);
+    if(e->value == NULL) {
+        e->hash = hash;
+        e->len = (uint32_t)len;
+        if(len <= HT_INLINE_KEY_MAX) {
+            memcpy(e->key.small, key, len + 1);
+        } else {
+            e->key.big = key;
+        }
+        m->items++;
+    }
+    e->value = value;
+    return 0;
+}
+
+void *ht_inline_get(InlineMap *m, const char *key) {
+    size_t len = strlen(key);
+    return ht__inline_find(m, key, len, ht__inline_hash(key, len))->value;
+}
+
+size_t ht_inline_length(InlineMap *m) {
+    return m->items;
+}
+
+void ht_inline_destroy(InlineMap *m) {
+    free(m->ht);
+    free(m);
+}
+
+
+// -- MultiMap
+
+#ifndef HT_MULTIMAP_CHUNK_MAX
+#define HT_MULTIMAP_CHUNK_MAX 4096
+#endif
+
+#define HT_MULTIMAP_CHUNK_MIN 4
+
+typedef struct ht__multi_chunk {
+    struct ht__multi_chunk *next;
+    size_t count;
+    size_t cap;
+    void *values[];
+} ht__multi_chunk;
+
+// The first chunk is allocated together with its group, small groups
+// cost a single allocation
+typedef struct {
+    size_t count;
+    ht__multi_chunk *head;
+    ht__multi_chunk *tail;
+} ht__multi_group;
+
+typedef struct {
+    Map *index;
+} MultiMap;
+
+typedef struct {
+    ht__multi_chunk *chunk;
+    size_t pos;
+} MultiMapIter;
+
+MultiMap *ht_multimap_new(size_t capacity) {
+    MultiMap *mm = (MultiMap *)malloc(sizeof(MultiMap));
+    if(mm == NULL) {
+        return NULL;
+    }
+
+    mm->index = ht_new_map(capacity > 0 ? capacity : 16);
+    if(mm->index == NULL) {
+        free(mm);
+        return NULL;
+    }
+    return mm;
+}
+
+static ht__multi_group *ht__multi_group_new(void) {
+    ht__multi_group *g = (ht__multi_group *)malloc(sizeof(ht__multi_group) + sizeof(ht__multi_chunk) +
+                                                   HT_MULTIMAP_CHUNK_MIN * sizeof(void *));
+    if(g == NULL) {
+        return NULL;
+    }
+
+    g->count = 0;
+    g->head = (ht__multi_chunk *)(g + 1);
+    g->head->next = NULL;
+    g->head->count = 0;
+    g->head->cap = HT_MULTIMAP_CHUNK_MIN;
+    g->tail = g->head;
+    return g;
+}
+
+int ht_multimap_append(MultiMap *mm, const char *key, void *value) {
+    if(key == NULL) {
+        return -1;
+    }
+
+    ht__multi_group *g = (ht__multi_group *)ht_get(mm->index, key);
+    if(g == NULL) {
+        g = ht__multi_group_new();
+        if(g == NULL) {
+            return -1;
+        }
+        if(ht_set(mm->index, key, g) == NULL) {
+            free(g);
+            return -1;
+        }
+    }
+
+    ht__multi_chunk *c = g->tail;
+    if(c->count == c->cap) {
+        size_t cap = c->cap * 2 > HT_MULTIMAP_CHUNK_MAX ? HT_MULTIMAP_CHUNK_MAX : c->cap * 2;
+        ht__multi_chunk *n = (ht__multi_chunk *)malloc(sizeof(ht__multi_chunk) + cap * sizeof(void *));
+        if(n == NULL) {
+            return -1;
+        }
+        n->next = NULL;
+        n->count = 0;
+        n->cap = cap;
+        c->next = n;
+        g->tail = n;
+        c = n;
+    }
+
+    c->values[c->count++] = value;
+    g->count++;
+    return 0;
+}
+
+size_t ht_multimap_count(MultiMap *mm, const char *key) {
+    ht__multi_group *g = (ht__multi_group *)ht_get(mm->index, key);
+    return g == NULL ? 0 : g->count;
+}
+
+MultiMapIter ht_multimap_range(MultiMap *mm, const char *key) {
+    ht__multi_group *g = (ht__multi_group *)ht_get(mm->index, key);
+    MultiMapIter it = { g == NULL ? NULL : g->head, 0 };
+    return it;
+}
+
+int ht_multimap_next(MultiMapIter *it, void **value) {
+    if(it->chunk == NULL) {
+        return 0;
+    }
+
+    // Stay on the tail when it runs out, so later appends are still seen
+    while(it->pos >= it->chunk->count) {
+        if(it->chunk->next == NULL) {
+            return 0;
+        }
+        it->chunk = it->chunk->next;
+        it->pos = 0;
+    }
+
+    *value = it->chunk->values[it->pos++];
+    return 1;
+}
+
+size_t ht_multimap_length(MultiMap *mm) {
+    return ht_length(mm->index);
+}
+
+void ht_multimap_destroy(MultiMap *mm) {
+    for(size_t i = 0; i < mm->index->capacity; i++) {
+        ht__multi_group *g = (ht__multi_group *)mm->index->ht[i].value;
+        if(g == NULL) {
+            continue;
+        }
+
+        ht__multi_chunk *c = g->head->next;
+        while(c != NULL) {
+            ht__multi_chunk *next = c->next;
+            free(c);
+            c = next;
+        }
+        free(g);
+    }
+    ht_free(mm->index);
+    free(mm);
 }
 
 
@@ -66,6 +66,25 @@
  *   
  *   saul_free_matrix(m);
  * 
+ * Example - Elementwise work without a call per element:
+ * 
+ *   // Built-in kernels, vectorized and dispatched like add/sub
+ *   saul_matrix_scale(m, 0.5f);
+ *   saul_matrix_axpy(-lr, grad, w);          // w += -lr * grad
+ *   saul_matrix_clamp(m, -1.0f, 1.0f);
+ *   saul_matrix_relu(m);
+ *   saul_matrix_exp(m);                      // about 2 ulp off expf()
+ * 
+ *   // Anything else: a macro the compiler inlines and vectorizes...
+ *   SAUL_MAP(m, x, x * x + 1.0f);
+ *   SAUL_MAP2(a, b, x, y, x > y ? x : y);    // a = max(a, b)
+ * 
+ *   // ...or a callback per contiguous row
+ *   void halve(float *row, int n, void *ctx) {
+ *       for (int j = 0; j < n; j++) row[j] *= 0.5f;
+ *   }
+ *   saul_matrix_for_each_row(m, halve, NULL);
+ * 
  * Example - Safe element access:
  * 
  *   Matrix *m = saul_new_matrix(3, 3);
@@ -83,13 +102,153 @@
  *   
  *   saul_free_matrix(m);
  * 
+ * Memory layout:
+ *   Elements live in one 64-byte aligned, zero-initialized buffer, row-major.
+ *   Each row starts stride floats after the previous one; stride is cols
+ *   rounded up to SAUL_ALIGN floats so every row starts on a cache line.
+ *   Use SAUL_AT(m, i, j) for unchecked access:
+ * 
+ *   for (int i = 0; i < m->rows; i++) {
+ *       float *row = &SAUL_AT(m, i, 0);
+ *       for (int j = 0; j < m->cols; j++) row[j] *= 2.0f;
+ *   }
+ * 
+ * Views:
+ *   A view shares its parent's buffer: items points into it and stride
+ *   stays the parent's, so no element is copied. Every operation takes
+ *   views as well as matrices. saul_free_matrix() on a view frees only the
+ *   header, and a view must not outlive its parent.
+ * 
+ *   Matrix *blk = saul_view(m, 8, 8, 4, 4);   // m[8..12][8..12]
+ *   Matrix *r = saul_row(m, 2);               // 1 x cols
+ *   Matrix *c = saul_col(m, 3);               // rows x 1
+ *   Matrix *d = saul_diag(m);                 // n x 1, stride + 1
+ *   Matrix v;                                 // header on the stack: no malloc,
+ *                                             // and never saul_free_matrix()
+ *   saul_view_into(&v, m, 0, 0, 2, 2);
+ * 
+ * Multiplication:
+ *   saul_matrix_mul() runs a packed, cache-blocked GEMM. Block sizes can be
+ *   tuned at compile time with SAUL_GEMM_MC (rows of A kept in L2),
+ *   SAUL_GEMM_KC (shared dimension per pass) and SAUL_GEMM_NC (columns of B
+ *   per packed panel).
+ * 
+ * CPU dispatch:
+ *   saul_matrix_add(), saul_matrix_sub(), the GEMM micro-kernel and the
+ *   row update used by the factorizations come in scalar, SSE2, AVX2+FMA
+ *   and AVX-512 versions, all compiled into the same binary. saul_init()
+ *   checks the CPU once and picks the best supported level; operations
+ *   call it themselves (once, under pthread_once) if you didn't. Switching
+ *   levels swaps the whole kernel table atomically, so threads racing on
+ *   first use or on saul_set_isa() never mix levels.
+ * 
+ *   saul_init();
+ *   saul_set_isa(SAUL_ISA_AVX2);   // -1 if the CPU lacks it, nothing changes
+ *   saul_isa isa = saul_get_isa();
+ * 
+ * Threads:
+ *   saul keeps a persistent pool of worker threads. saul_set_num_threads(n)
+ *   resizes it (n <= 0 means one per online CPU, 1 means no workers) and
+ *   the calling thread always works too. The pool starts with one thread;
+ *   call saul_set_num_threads() once at startup to use more. GEMM splits C
+ *   into macro-tiles, add/sub split rows; work smaller than
+ *   SAUL_PARALLEL_MIN elements stays on the caller. Link with -lpthread -lm.
+ * 
+ * Allocation-free operations:
+ *   The *_into variants write into a matrix the caller already owns, so hot
+ *   loops can reuse their buffers. add/sub outputs may alias an input;
+ *   mul, transpose and gemm outputs may not (they return -1).
+ * 
+ *   saul_matrix_add_into(a, b, out);           // out = a + b
+ *   saul_matrix_mul_into(a, b, out);           // out = a * b
+ *   saul_matrix_transpose_into(a, at);         // at = a^T
+ *   // BLAS-style: C = alpha * op(A) * op(B) + beta * C, op is SAUL_TRANS
+ *   // or SAUL_NO_TRANS; transposes only change how A and B are read
+ *   saul_gemm(1.0f, a, SAUL_TRANS, b, SAUL_NO_TRANS, 1.0f, c);   // c += a^T b
+ * 
+ * Linear systems:
+ *   saul_lu() factors a square matrix in place as P A = L U with partial
+ *   pivoting (L unit lower and U share the buffer, piv[i] is the row swapped
+ *   with row i). It works on SAUL_LU_NB-wide panels and sends the trailing
+ *   updates through GEMM. It returns -2 if A is singular.
+ * 
+ *   int piv[3];
+ *   if (saul_lu(a, piv) == 0) {
+ *       saul_lu_solve(a, piv, b);     // b (3 x k) is overwritten with X
+ *   }
+ *   float d = saul_det(m);            // 0 if singular, NAN if not square
+ *   Matrix *inv = saul_inverse(m);    // NULL if singular
+ * 
+ *   Symmetric positive-definite systems take half the work with
+ *   saul_cholesky(), which overwrites the lower triangle with L (A = L L^T).
+ *   It only reads the lower triangle and never writes the upper one; it
+ *   returns -2 if A is not positive definite.
+ * 
+ *   if (saul_cholesky(cov) == 0) {
+ *       saul_cholesky_solve(cov, b);  // b is overwritten with X
+ *   }
+ * 
+ *   Overdetermined systems go through Householder QR instead of the normal
+ *   equations. saul_qr() leaves R in the upper triangle and the reflectors
+ *   below it (tau holds min(rows, cols) scales); each SAUL_LU_NB-column
+ *   panel is applied to the rest of the matrix as one compact WY block.
+ *   saul_lstsq() returns the X minimizing ||A X - B|| for rows >= cols, or
+ *   NULL if A is rank deficient (some |R_ii| <= rows * FLT_EPSILON *
+ *   max |R_jj|).
+ * 
+ *   Matrix *x = saul_lstsq(a, b);     // new matrix, cols(a) x cols(b)
+ * 
+ *   saul_gauss_reduction() brings any matrix to row echelon form, with
+ *   pivoting, and returns its rank.
+ * 
+ * Sparse matrices:
+ *   SparseMatrix keeps only the nonzeros, in CSR (SAUL_CSR, rows
+ *   compressed) or CSC (SAUL_CSC, columns compressed), so memory and time
+ *   scale with nnz. Build one from COO triplets (duplicates are summed)
+ *   or from a dense Matrix; indices come out sorted.
+ * 
+ *   int ri[] = { 0, 1, 1 }, ci[] = { 2, 0, 0 };
+ *   float v[] = { 1.0f, 2.0f, 3.0f };             // (1, 0) ends up 5.0
+ *   SparseMatrix *s = saul_sparse_from_coo(2, 3, 3, ri, ci, v, SAUL_CSR);
+ *   saul_sparse_spmv(s, x, y);                    // y = S x
+ *   saul_sparse_spmm(s, b, c);                    // c = S b, both dense
+ *   saul_sparse_free(s);
+ * 
+ *   CSR products are split over the thread pool by nonzeros. CSC products
+ *   scatter their writes and stay on one thread, so convert with
+ *   saul_sparse_convert() before a hot loop.
+ *
+ * Element types:
+ *   Matrix holds float. MatrixF64 (double), MatrixI32 (int32_t) and
+ *   MatrixI8 (int8_t) come with the same core API under saul_f64_,
+ *   saul_i32_ and saul_i8_; saul_f32_ names the float one. Each type gets
+ *   its own add/sub/axpy/scale kernels per ISA level, picked together with
+ *   the float ones, so nothing switches on the type at run time (AVX512
+ *   falls back to AVX2 kernels for them without avx512bw). MatrixF64
+ *   also has lu, lu_solve, det, cholesky and cholesky_solve. Integer
+ *   results wrap around. The packed GEMM, QR, sparse and map kernels are
+ *   float only.
+ *
+ *   MatrixF64 *a = saul_f64_new_matrix(n, n);
+ *   saul_f64_matrix_mul_into(a, b, c);
+ *   saul_f64_cholesky(a);
+ *   MatrixI8 *q = saul_i8_new_matrix(n, n);
+ *   saul_i8_matrix_add(q, r);
+ *
+ *   SAUL_DEFINE_MATRIX_TYPE(prefix, Type, T, U) stamps the same API out
+ *   for another type (U is T for floating point, its unsigned twin for
+ *   integers), and SAUL_DEFINE_SOLVERS(prefix, Type, T) the solvers.
+ *
  * Note: Matrix addition and subtraction modify the first matrix in-place.
  *       Matrix multiplication returns a new matrix that must be freed.
+ *       saul_matrix_transpose() replaces *m and frees the old matrix; it
+ *       returns -1 on a view (use saul_matrix_transpose_into() instead).
  *       Always check return values for error conditions.
  * 
  * Return codes:
  *  0 or positive: Success
  * -1: Error (dimension mismatch, out of bounds, etc.)
+ * -2: Singular (or, for Cholesky, not positive definite) matrix
  *  NULL: Memory allocation failure or invalid operation
  */
 
@@ -98,29 +257,142 @@
 
 
 #ifdef SAUL_IMPLEMENTATION
+#include <float.h>
 #include <malloc.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+// Row stride granularity in floats, 16 floats = one 64-byte cache line
+#ifndef SAUL_ALIGN
+#define SAUL_ALIGN 16
+#endif
 
 typedef struct {
     int rows;
     int cols;
-    float **items;
+    int stride;
+    float *items;
+    int owns_items;
 } Matrix;
 
+#define SAUL_AT(m, i, j) ((m)->items[(size_t)(i) * (m)->stride + (j)])
+
+#define SAUL_NO_TRANS 0
+#define SAUL_TRANS 1
+
+typedef enum {
+    SAUL_CSR,
+    SAUL_CSC
+} saul_sparse_format;
+
+// Compressed sparse rows (or columns): the entries of row i (column i for
+// CSC) are idx[ptr[i]] .. idx[ptr[i + 1] - 1], sorted, with their values
+typedef struct {
+    int rows;
+    int cols;
+    int nnz;
+    saul_sparse_format format;
+    int *ptr;
+    int *idx;
+    float *values;
+} SparseMatrix;
+
+typedef enum {
+    SAUL_ISA_SCALAR,
+    SAUL_ISA_SSE2,
+    SAUL_ISA_AVX2,
+    SAUL_ISA_AVX512
+} saul_isa;
+
 typedef void (* saul_call_back)(Matrix *, int, int);
 typedef void (* saul_call_back_double_matrix)(Matrix *, Matrix *, int, int);
+typedef void (* saul_row_call_back)(float *, int, void *);
+typedef void (* saul_row_call_back_double)(float *, float *, int, void *);
+
+// Applies expr to every element, x names the element. Expanded in place
+// and run in fixed 16-element chunks, so even -O2 vectorizes the body
+#define SAUL_MAP(m, x, expr) do { \
+    Matrix *saul_map_m_ = (m); \
+    for(int saul_map_i_ = 0; saul_map_i_ < saul_map_m_->rows; saul_map_i_++) { \
+        float *saul_map_row_ = &SAUL_AT(saul_map_m_, saul_map_i_, 0); \
+        int saul_map_j_ = 0; \
+        for(; saul_map_j_ + 16 <= saul_map_m_->cols; saul_map_j_ += 16) { \
+            float *saul_map_p_ = saul_map_row_ + saul_map_j_; \
+            for(int saul_map_l_ = 0; saul_map_l_ < 16; saul_map_l_++) { \
+                float x = saul_map_p_[saul_map_l_]; \
+                (void)x; \
+                saul_map_p_[saul_map_l_] = (expr); \
+            } \
+        } \
+        for(; saul_map_j_ < saul_map_m_->cols; saul_map_j_++) { \
+            float x = saul_map_row_[saul_map_j_]; \
+            (void)x; \
+            saul_map_row_[saul_map_j_] = (expr); \
+        } \
+    } \
+} while(0)
+
+// dst = expr(x, y) elementwise with x from dst and y from src, same shape
+#define SAUL_MAP2(dst, src, x, y, expr) do { \
+    Matrix *saul_map_d_ = (dst); \
+    Matrix *saul_map_s_ = (src); \
+    for(int saul_map_i_ = 0; saul_map_i_ < saul_map_d_->rows; saul_map_i_++) { \
+        float *saul_map_row_ = &SAUL_AT(saul_map_d_, saul_map_i_, 0); \
+        const float *saul_map_src_ = &SAUL_AT(saul_map_s_, saul_map_i_, 0); \
+        int saul_map_j_ = 0; \
+        for(; saul_map_j_ + 16 <= saul_map_d_->cols; saul_map_j_ += 16) { \
+            float saul_map_y_[16]; \
+            memcpy(saul_map_y_, saul_map_src_ + saul_map_j_, sizeof(saul_map_y_)); \
+            float *saul_map_p_ = saul_map_row_ + saul_map_j_; \
+            for(int saul_map_l_ = 0; saul_map_l_ < 16; saul_map_l_++) { \
+                float x = saul_map_p_[saul_map_l_]; \
+                float y = saul_map_y_[saul_map_l_]; \
+                (void)x; \
+                (void)y; \
+                saul_map_p_[saul_map_l_] = (expr); \
+            } \
+        } \
+        for(; saul_map_j_ < saul_map_d_->cols; saul_map_j_++) { \
+            float x = saul_map_row_[saul_map_j_]; \
+            float y = saul_map_src_[saul_map_j_]; \
+            (void)x; \
+            (void)y; \
+            saul_map_row_[saul_map_j_] = (expr); \
+        } \
+    } \
+} while(0)
 
 
 // -- Setup/End
+void saul_init(void);
+int saul_set_isa(saul_isa isa);
+saul_isa saul_get_isa(void);
+int saul_set_num_threads(int n);
+int saul_get_num_threads(void);
 Matrix *saul_new_matrix(int rows, int cols);
 void saul_free_matrix(Matrix *m);
 
+// -- Views
+int saul_view_into(Matrix *view, Matrix *m, int r0, int c0, int rows, int cols);
+Matrix *saul_view(Matrix *m, int r0, int c0, int rows, int cols);
+Matrix *saul_row(Matrix *m, int i);
+Matrix *saul_col(Matrix *m, int j);
+Matrix *saul_diag(Matrix *m);
+
 // -- Utilities
 int saul_matrix_set_value(Matrix *m, int i, int j, float value);
 float saul_get_value_by_index(Matrix *m, int i, int j);
 void saul_matrix_for_each(Matrix *m, saul_call_back cb);
 int saul_matrix_for_each_double(Matrix *m1, Matrix *m2, saul_call_back_double_matrix cb);
+void saul_matrix_for_each_row(Matrix *m, saul_row_call_back cb, void *ctx);
+int saul_matrix_for_each_row_double(Matrix *m1, Matrix *m2, saul_row_call_back_double cb, void *ctx);
 int saul_check_boundaries(Matrix *m, int i, int j);
 int saul_is_upper_triangular(Matrix *m);
 
@@ -129,7 +401,41 @@ int saul_matrix_add(Matrix *m1, Matrix *m2);
 int saul_matrix_sub(Matrix *m1, Matrix *m2);
 Matrix *saul_matrix_mul(Matrix *m1, Matrix *m2);
 int saul_gauss_reduction(Matrix **_m);
-void saul_matrix_transpose(Matrix **m);
+int saul_matrix_transpose(Matrix **m);
+
+// -- Elementwise kernels
+void saul_matrix_scale(Matrix *m, float alpha);
+int saul_matrix_axpy(float alpha, Matrix *x, Matrix *y);
+void saul_matrix_clamp(Matrix *m, float lo, float hi);
+void saul_matrix_relu(Matrix *m);
+void saul_matrix_exp(Matrix *m);
+
+// -- Operations into caller-provided matrices
+int saul_matrix_add_into(Matrix *a, Matrix *b, Matrix *out);
+int saul_matrix_sub_into(Matrix *a, Matrix *b, Matrix *out);
+int saul_matrix_mul_into(Matrix *a, Matrix *b, Matrix *out);
+int saul_matrix_transpose_into(Matrix *m, Matrix *out);
+int saul_gemm(float alpha, Matrix *a, int trans_a, Matrix *b, int trans_b, float beta, Matrix *c);
+
+// -- Linear systems
+int saul_lu(Matrix *a, int *piv);
+int saul_lu_solve(Matrix *lu, const int *piv, Matrix *b);
+float saul_det(Matrix *m);
+Matrix *saul_inverse(Matrix *m);
+int saul_cholesky(Matrix *a);
+int saul_cholesky_solve(Matrix *l, Matrix *b);
+int saul_qr(Matrix *a, float *tau);
+Matrix *saul_lstsq(Matrix *a, Matrix *b);
+
+// -- Sparse
+SparseMatrix *saul_sparse_from_coo(int rows, int cols, int nnz, const int *ri, const int *ci,
+                                   const float *values, saul_sparse_format format);
+SparseMatrix *saul_sparse_from_dense(Matrix *m, saul_sparse_format format);
+SparseMatrix *saul_sparse_convert(SparseMatrix *s, saul_sparse_format format);
+Matrix *saul_sparse_to_dense(SparseMatrix *s);
+int saul_sparse_spmv(SparseMatrix *a, const float *x, float *y);
+int saul_sparse_spmm(SparseMatrix *a, Matrix *b, Matrix *c);
+void saul_sparse_free(SparseMatrix *s);
 
 int saul_check_boundaries(Matrix *m, int i, int j) {
     if(m->cols <= j || i < 0 ) return -1;
@@ -161,29 +467,100 @@ int saul_matrix_for_each_double(Matrix *m1, Matrix *m2, saul_call_back_double_ma
     return 0;
 }
 
+void saul_matrix_for_each_row(Matrix *m, saul_row_call_back cb, void *ctx) {
+    for(int i = 0; i < m->rows; i++) {
+        cb(&SAUL_AT(m, i, 0), m->cols, ctx);
+    }
+}
+
+int saul_matrix_for_each_row_double(Matrix *m1, Matrix *m2, saul_row_call_back_double cb, void *ctx) {
+    if(m1->rows != m2->rows || m1->cols != m2->cols) {
+        return -1;
+    }
+
+    for(int i = 0; i < m1->rows; i++) {
+        cb(&SAUL_AT(m1, i, 0), &SAUL_AT(m2, i, 0), m1->cols, ctx);
+    }
+
+    return 0;
+}
+
 Matrix *saul_new_matrix(int rows, int cols) {
+    if(rows < 0 || cols < 0) {
+        return NULL;
+    }
+
     Matrix *m = (Matrix *)malloc(sizeof(Matrix)); 
+    if(m == NULL) {
+        return NULL;
+    }
 
     m->cols = cols;
     m->rows = rows;
-    m->items = (float **)malloc(rows * sizeof(float *));
+    m->stride = (cols + SAUL_ALIGN - 1) / SAUL_ALIGN * SAUL_ALIGN;
 
-    for(int i = 0; i < rows; i++) {
-        m->items[i] = (float *)malloc(cols * sizeof(float));
-        for(int j = 0; j < cols; j++) {
-            m->items[i][j] = 0;
-        }
+    size_t bytes = (size_t)rows * m->stride * sizeof(float);
+    void *items = NULL;
+    if(posix_memalign(&items, 64, bytes > 0 ? bytes : 64) != 0) {
+        free(m);
+        return NULL;
     }
+    memset(items, 0, bytes);
+    m->items = (float *)items;
+    m->owns_items = 1;
     return m;
 }
 
+int saul_view_into(Matrix *view, Matrix *m, int r0, int c0, int rows, int cols) {
+    if(r0 < 0 || c0 < 0 || rows < 0 || cols < 0 || r0 + rows > m->rows || c0 + cols > m->cols) {
+        return -1;
+    }
+
+    view->rows = rows;
+    view->cols = cols;
+    view->stride = m->stride;
+    view->items = m->items + (size_t)r0 * m->stride + c0;
+    view->owns_items = 0;
+    return 0;
+}
+
+Matrix *saul_view(Matrix *m, int r0, int c0, int rows, int cols) {
+    Matrix *view = (Matrix *)malloc(sizeof(Matrix));
+    if(view == NULL) {
+        return NULL;
+    }
+    if(saul_view_into(view, m, r0, c0, rows, cols) < 0) {
+        free(view);
+        return NULL;
+    }
+    return view;
+}
+
+Matrix *saul_row(Matrix *m, int i) {
+    return saul_view(m, i, 0, 1, m->cols);
+}
+
+Matrix *saul_col(Matrix *m, int j) {
+    return saul_view(m, 0, j, m->rows, 1);
+}
+
+// A column vector whose rows are stride + 1 apart, which lands on m[i][i]
+Matrix *saul_diag(Matrix *m) {
+    int n = m->rows < m->cols ? m->rows : m->cols;
+    Matrix *view = saul_view(m, 0, 0, n, n > 0 ? 1 : 0);
+    if(view != NULL) {
+        view->stride = m->stride + 1;
+    }
+    return view;
+}
+
 int saul_matrix_set_value(Matrix *m, int i, int j, float value) {
 
     if(saul_check_boundaries(m, i, j) < 0) {
         return -1;
     }
 
-    m->items[i][j] = value;
+    SAUL_AT(m, i, j) = value;
     return 0;
 }
 
@@ -192,153 +569,2370 @@ float saul_get_value_by_index(Matrix *m, int i, int j) {
         return -1;
     }
 
-    return m->items[i][j];
+    return SAUL_AT(m, i, j);
 }
 
 
 // --------------------------------------- PRIVATE
 
-static inline void saul_private_add_each(Matrix *m1, Matrix *m2, int i, int j) {
-    int a = saul_get_value_by_index(m1, i, j);
-    int b = saul_get_value_by_index(m2, i, j);
-    saul_matrix_set_value(m1, i, j, a + b);
+// -- GEMM
+//
+// Goto-style blocking: a KC x NC panel of B is packed once per (jc, pc)
+// and stays in L3/L2, an MC x KC block of A is packed per ic and stays in
+// L2, and the micro-kernel keeps an MR x NR tile of C in registers while
+// it streams both packed slivers from L1. Edge slivers are zero padded
+// so the kernel never branches on the tile size.
+
+#define SAUL_GEMM_MR 6
+#define SAUL_GEMM_NR 16
+
+#ifndef SAUL_GEMM_MC
+#define SAUL_GEMM_MC 96
+#endif
+#ifndef SAUL_GEMM_KC
+#define SAUL_GEMM_KC 256
+#endif
+#ifndef SAUL_GEMM_NC
+#define SAUL_GEMM_NC 4096
+#endif
+
+// A block as MR-row slivers, column by column, scaled by alpha
+static void saul_private_pack_a(int mc, int kc, const float *a, int rsa, int csa, float alpha, float *dst) {
+    for(int ir = 0; ir < mc; ir += SAUL_GEMM_MR) {
+        int mr = mc - ir < SAUL_GEMM_MR ? mc - ir : SAUL_GEMM_MR;
+        for(int p = 0; p < kc; p++) {
+            for(int i = 0; i < SAUL_GEMM_MR; i++) {
+                *dst++ = i < mr ? alpha * a[(size_t)(ir + i) * rsa + (size_t)p * csa] : 0.0f;
+            }
+        }
+    }
 }
 
-static inline void saul_private_sub_each(Matrix *m1, Matrix *m2, int i, int j) {
-    int a = saul_get_value_by_index(m1, i, j);
-    int b = saul_get_value_by_index(m2, i, j);
-    saul_matrix_set_value(m1, i, j, a - b);
+// B panel as NR-column slivers, row by row
+static void saul_private_pack_b(int kc, int nc, const float *b, int rsb, int csb, float *dst) {
+    for(int jr = 0; jr < nc; jr += SAUL_GEMM_NR) {
+        int nr = nc - jr < SAUL_GEMM_NR ? nc - jr : SAUL_GEMM_NR;
+        for(int p = 0; p < kc; p++) {
+            const float *src = b + (size_t)p * rsb + (size_t)jr * csb;
+            if(csb == 1 && nr == SAUL_GEMM_NR) {
+                memcpy(dst, src, SAUL_GEMM_NR * sizeof(float));
+                dst += SAUL_GEMM_NR;
+                continue;
+            }
+            for(int j = 0; j < SAUL_GEMM_NR; j++) {
+                *dst++ = j < nr ? src[(size_t)j * csb] : 0.0f;
+            }
+        }
+    }
 }
-// ---------------------------------------
 
+// -- Kernels and CPU dispatch
+//
+// Every hot kernel exists once per ISA level. The x86 variants are compiled
+// with target attributes, so one binary carries all of them, and
+// saul_init() picks the best one the CPU supports with cpuid. Kernels are
+// written with GCC/clang vector extensions at the native width of their
+// target; wider generic vectors get lowered through the stack.
 
-int saul_matrix_add(Matrix *m1, Matrix *m2) {
-    if(m1->rows != m2->rows || m1->cols != m2->cols) {
-        return -1;
+typedef float saul_private_v4 __attribute__((vector_size(16)));
+typedef float saul_private_v8 __attribute__((vector_size(32)));
+typedef float saul_private_v16 __attribute__((vector_size(64)));
+typedef int saul_private_i4 __attribute__((vector_size(16)));
+typedef int saul_private_i8 __attribute__((vector_size(32)));
+typedef int saul_private_i16 __attribute__((vector_size(64)));
+
+typedef void (*saul_private_kernel_fn)(int, const float *, const float *, float *, int, int, int);
+typedef void (*saul_private_ewise_fn)(float *, const float *, const float *, int);
+typedef void (*saul_private_axpy_fn)(float *, const float *, float, int);
+typedef void (*saul_private_map_fn)(float *, int, float, float);
+
+// C[mr x nr] += A sliver * B sliver; packed B rows are 64-byte aligned.
+// Fully unrolled so acc lives in registers even at -O2
+#define SAUL_PRIVATE_DEFINE_KERNEL(name, attr, vec, width) \
+static attr void name(int kc, const float *restrict a, const float *restrict b, \
+                      float *restrict c, int ldc, int mr, int nr) { \
+    enum { NV = SAUL_GEMM_NR / (width) }; \
+    vec acc[SAUL_GEMM_MR][NV]; \
+    _Pragma("GCC unroll 8") \
+    for(int i = 0; i < SAUL_GEMM_MR; i++) { \
+        _Pragma("GCC unroll 4") \
+        for(int v = 0; v < NV; v++) { \
+            acc[i][v] = (vec){0}; \
+        } \
+    } \
+    for(int p = 0; p < kc; p++) { \
+        vec bp[NV]; \
+        _Pragma("GCC unroll 4") \
+        for(int v = 0; v < NV; v++) { \
+            bp[v] = ((const vec *)b)[v]; \
+        } \
+        _Pragma("GCC unroll 8") \
+        for(int i = 0; i < SAUL_GEMM_MR; i++) { \
+            float ai = a[i]; \
+            _Pragma("GCC unroll 4") \
+            for(int v = 0; v < NV; v++) { \
+                acc[i][v] += ai * bp[v]; \
+            } \
+        } \
+        a += SAUL_GEMM_MR; \
+        b += SAUL_GEMM_NR; \
+    } \
+    if(mr == SAUL_GEMM_MR && nr == SAUL_GEMM_NR) { \
+        for(int i = 0; i < SAUL_GEMM_MR; i++) { \
+            for(int v = 0; v < NV; v++) { \
+                vec cv; \
+                float *dst = c + (size_t)i * ldc + v * (width); \
+                memcpy(&cv, dst, sizeof(cv)); \
+                cv += acc[i][v]; \
+                memcpy(dst, &cv, sizeof(cv)); \
+            } \
+        } \
+        return; \
+    } \
+    float tile[SAUL_GEMM_MR][SAUL_GEMM_NR]; \
+    memcpy(tile, acc, sizeof(tile)); \
+    for(int i = 0; i < mr; i++) { \
+        for(int j = 0; j < nr; j++) { \
+            c[(size_t)i * ldc + j] += tile[i][j]; \
+        } \
+    } \
+}
+
+// dst[j] = a[j] op b[j], rows may be unaligned (views) and dst may be a or b
+#define SAUL_PRIVATE_DEFINE_EWISE(name, attr, vec, width, op) \
+static attr void name(float *dst, const float *a, const float *b, int n) { \
+    int j = 0; \
+    for(; j + (width) <= n; j += (width)) { \
+        vec x, y; \
+        memcpy(&x, a + j, sizeof(x)); \
+        memcpy(&y, b + j, sizeof(y)); \
+        x = x op y; \
+        memcpy(dst + j, &x, sizeof(x)); \
+    } \
+    for(; j < n; j++) { \
+        dst[j] = a[j] op b[j]; \
+    } \
+}
+
+// y[j] += s * x[j], the row update behind the factorizations
+#define SAUL_PRIVATE_DEFINE_AXPY(name, attr, vec, width) \
+static attr void name(float *restrict y, const float *restrict x, float s, int n) { \
+    int j = 0; \
+    for(; j + (width) <= n; j += (width)) { \
+        vec xv, yv; \
+        memcpy(&xv, x + j, sizeof(xv)); \
+        memcpy(&yv, y + j, sizeof(yv)); \
+        yv += s * xv; \
+        memcpy(y + j, &yv, sizeof(yv)); \
+    } \
+    for(; j < n; j++) { \
+        y[j] += s * x[j]; \
+    } \
+}
+
+// row[j] = op(row[j]) with parameters a and b. op gets the vector and
+// its same-sized int vector type, comparisons give all-ones lane masks.
+// The tail goes through a zero-padded vector so op is written once
+#define SAUL_PRIVATE_DEFINE_MAP(name, attr, vec, ivec, width, op) \
+static attr void name(float *row, int n, float pa, float pb) { \
+    vec a = (vec){0} + pa; \
+    vec b = (vec){0} + pb; \
+    (void)a; \
+    (void)b; \
+    int j = 0; \
+    for(; j + (width) <= n; j += (width)) { \
+        vec x; \
+        memcpy(&x, row + j, sizeof(x)); \
+        x = op(x, a, b, vec, ivec); \
+        memcpy(row + j, &x, sizeof(x)); \
+    } \
+    if(j < n) { \
+        vec x = {0}; \
+        memcpy(&x, row + j, (size_t)(n - j) * sizeof(float)); \
+        x = op(x, a, b, vec, ivec); \
+        memcpy(row + j, &x, (size_t)(n - j) * sizeof(float)); \
+    } \
+}
+
+#define SAUL_PRIVATE_SELECT(mask, p, q, vec, ivec) ((vec)(((ivec)(p) & (mask)) | ((ivec)(q) & ~(mask))))
+#define SAUL_PRIVATE_OP_SCALE(x, a, b, vec, ivec) ((x) * (a))
+#define SAUL_PRIVATE_OP_RELU(x, a, b, vec, ivec) ((vec)((ivec)(x) & ((x) > 0.0f)))
+#define SAUL_PRIVATE_OP_CLAMP(x, a, b, vec, ivec) \
+    SAUL_PRIVATE_SELECT((x) > (b), b, SAUL_PRIVATE_SELECT((x) < (a), a, x, vec, ivec), vec, ivec)
+
+// Cephes expf: e^x = 2^n e^r with |r| <= ln2 / 2, a degree 5 polynomial
+// for e^r and 2^n built in the exponent bits (n = 128 as 2^127 * 2). About
+// 2 ulp; overflow gives inf and results below FLT_MIN flush to 0
+#define SAUL_PRIVATE_OP_EXP(x, a, b, vec, ivec) ({ \
+    vec one_ = (vec){0} + 1.0f; \
+    vec x_ = SAUL_PRIVATE_SELECT((x) > 88.7228390520683f, (vec){0} + 88.7228390520683f, x, vec, ivec); \
+    x_ = SAUL_PRIVATE_SELECT(x_ < -87.3365447505531f, (vec){0} - 87.3365447505531f, x_, vec, ivec); \
+    vec fx_ = x_ * 1.44269504088896341f + 0.5f; \
+    vec n_ = __builtin_convertvector(__builtin_convertvector(fx_, ivec), vec); \
+    n_ -= (vec)((ivec)one_ & (n_ > fx_)); \
+    x_ = x_ - n_ * 0.693359375f + n_ * 2.12194440e-4f; \
+    vec p_ = x_ * 1.9875691500e-4f + 1.3981999507e-3f; \
+    p_ = p_ * x_ + 8.3334519073e-3f; \
+    p_ = p_ * x_ + 4.1665795894e-2f; \
+    p_ = p_ * x_ + 1.6666665459e-1f; \
+    p_ = p_ * x_ + 5.0000001201e-1f; \
+    p_ = p_ * (x_ * x_) + x_ + 1.0f; \
+    vec top_ = (vec)((ivec)one_ & (n_ > 127.0f)); \
+    p_ = p_ * (top_ + 1.0f) * (vec)((__builtin_convertvector(n_ - top_, ivec) + 127) << 23); \
+    p_ = SAUL_PRIVATE_SELECT((x) > 88.7228390520683f, (vec){0} + INFINITY, p_, vec, ivec); \
+    SAUL_PRIVATE_SELECT((x) < -87.3365447505531f, (vec){0}, p_, vec, ivec); \
+})
+
+// Reference path, plain loops with no vector types
+static void saul_private_kernel_scalar(int kc, const float *restrict a, const float *restrict b,
+                                       float *restrict c, int ldc, int mr, int nr) {
+    float acc[SAUL_GEMM_MR][SAUL_GEMM_NR] = {{0}};
+    for(int p = 0; p < kc; p++) {
+        for(int i = 0; i < SAUL_GEMM_MR; i++) {
+            for(int j = 0; j < SAUL_GEMM_NR; j++) {
+                acc[i][j] += a[i] * b[j];
+            }
+        }
+        a += SAUL_GEMM_MR;
+        b += SAUL_GEMM_NR;
+    }
+    for(int i = 0; i < mr; i++) {
+        for(int j = 0; j < nr; j++) {
+            c[(size_t)i * ldc + j] += acc[i][j];
+        }
     }
-    saul_matrix_for_each_double(m1, m2, saul_private_add_each);
-    return 0;
 }
 
-int saul_matrix_sub(Matrix *m1, Matrix *m2) {
-    if(m1->rows != m2->rows || m1->cols != m2->cols) {
+static void saul_private_add_scalar(float *dst, const float *a, const float *b, int n) {
+    for(int j = 0; j < n; j++) dst[j] = a[j] + b[j];
+}
+
+static void saul_private_sub_scalar(float *dst, const float *a, const float *b, int n) {
+    for(int j = 0; j < n; j++) dst[j] = a[j] - b[j];
+}
+
+static void saul_private_axpy_scalar(float *restrict y, const float *restrict x, float s, int n) {
+    for(int j = 0; j < n; j++) y[j] += s * x[j];
+}
+
+static void saul_private_scale_scalar(float *row, int n, float a, float b) {
+    (void)b;
+    for(int j = 0; j < n; j++) row[j] *= a;
+}
+
+static void saul_private_clamp_scalar(float *row, int n, float a, float b) {
+    for(int j = 0; j < n; j++) row[j] = row[j] < a ? a : (row[j] > b ? b : row[j]);
+}
+
+static void saul_private_relu_scalar(float *row, int n, float a, float b) {
+    (void)a;
+    (void)b;
+    for(int j = 0; j < n; j++) row[j] = row[j] > 0.0f ? row[j] : 0.0f;
+}
+
+static void saul_private_exp_scalar(float *row, int n, float a, float b) {
+    (void)a;
+    (void)b;
+    for(int j = 0; j < n; j++) row[j] = expf(row[j]);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SAUL_X86 1
+
+SAUL_PRIVATE_DEFINE_KERNEL(saul_private_kernel_sse2, __attribute__((target("sse2"))), saul_private_v4, 4)
+SAUL_PRIVATE_DEFINE_EWISE(saul_private_add_sse2, __attribute__((target("sse2"))), saul_private_v4, 4, +)
+SAUL_PRIVATE_DEFINE_EWISE(saul_private_sub_sse2, __attribute__((target("sse2"))), saul_private_v4, 4, -)
+SAUL_PRIVATE_DEFINE_AXPY(saul_private_axpy_sse2, __attribute__((target("sse2"))), saul_private_v4, 4)
+SAUL_PRIVATE_DEFINE_MAP(saul_private_scale_sse2, __attribute__((target("sse2"))), saul_private_v4, saul_private_i4, 4, SAUL_PRIVATE_OP_SCALE)
+SAUL_PRIVATE_DEFINE_MAP(saul_private_clamp_sse2, __attribute__((target("sse2"))), saul_private_v4, saul_private_i4, 4, SAUL_PRIVATE_OP_CLAMP)
+SAUL_PRIVATE_DEFINE_MAP(saul_private_relu_sse2, __attribute__((target("sse2"))), saul_private_v4, saul_private_i4, 4, SAUL_PRIVATE_OP_RELU)
+SAUL_PRIVATE_DEFINE_MAP(saul_private_exp_sse2, __attribute__((target("sse2"))), saul_private_v4, saul_private_i4, 4, SAUL_PRIVATE_OP_EXP)
+
+SAUL_PRIVATE_DEFINE_KERNEL(saul_private_kernel_avx2, __attribute__((target("avx2,fma"))), saul_private_v8, 8)
+SAUL_PRIVATE_DEFINE_EWISE(saul_private_add_avx2, __attribute__((target("avx2,fma"))), saul_private_v8, 8, +)
+SAUL_PRIVATE_DEFINE_EWISE(saul_private_sub_avx2, __attribute__((target("avx2,fma"))), saul_private_v8, 8, -)
+SAUL_PRIVATE_DEFINE_AXPY(saul_private_axpy_avx2, __attribute__((target("avx2,fma"))), saul_private_v8, 8)
+SAUL_PRIVATE_DEFINE_MAP(saul_private_scale_avx2, __attribute__((target("avx2,fma"))), saul_private_v8, saul_private_i8, 8, SAUL_PRIVATE_OP_SCALE)
+SAUL_PRIVATE_DEFINE_MAP(saul_private_clamp_avx2, __attribute__((target("avx2,fma"))), saul_private_v8, saul_private_i8, 8, SAUL_PRIVATE_OP_CLAMP)
+SAUL_PRIVATE_DEFINE_MAP(saul_private_relu_avx2, __attribute__((target("avx2,fma"))), saul_private_v8, saul_private_i8, 8, SAUL_PRIVATE_OP_RELU)
+SAUL_PRIVATE_DEFINE_MAP(saul_private_exp_avx2, __attribute__((target("avx2,fma"))), saul_private_v8, saul_private_i8, 8, SAUL_PRIVATE_OP_EXP)
+
+SAUL_PRIVATE_DEFINE_KERNEL(saul_private_kernel_avx512, __attribute__((target("avx512f"))), saul_private_v16, 16)
+SAUL_PRIVATE_DEFINE_EWISE(saul_private_add_avx512, __attribute__((target("avx512f"))), saul_private_v16, 16, +)
+SAUL_PRIVATE_DEFINE_EWISE(saul_private_sub_avx512, __attribute__((target("avx512f"))), saul_private_v16, 16, -)
+SAUL_PRIVATE_DEFINE_AXPY(saul_private_axpy_avx512, __attribute__((target("avx512f"))), saul_private_v16, 16)
+SAUL_PRIVATE_DEFINE_MAP(saul_private_scale_avx512, __attribute__((target("avx512f"))), saul_private_v16, saul_private_i16, 16, SAUL_PRIVATE_OP_SCALE)
+SAUL_PRIVATE_DEFINE_MAP(saul_private_clamp_avx512, __attribute__((target("avx512f"))), saul_private_v16, saul_private_i16, 16, SAUL_PRIVATE_OP_CLAMP)
+SAUL_PRIVATE_DEFINE_MAP(saul_private_relu_avx512, __attribute__((target("avx512f"))), saul_private_v16, saul_private_i16, 16, SAUL_PRIVATE_OP_RELU)
+SAUL_PRIVATE_DEFINE_MAP(saul_private_exp_avx512, __attribute__((target("avx512f"))), saul_private_v16, saul_private_i16, 16, SAUL_PRIVATE_OP_EXP)
+#endif
+
+typedef struct {
+    saul_isa isa;
+    saul_private_kernel_fn kernel;
+    saul_private_ewise_fn add;
+    saul_private_ewise_fn sub;
+    saul_private_axpy_fn axpy;
+    saul_private_map_fn scale;
+    saul_private_map_fn clamp;
+    saul_private_map_fn relu;
+    saul_private_map_fn exp;
+} saul_private_ops_table;
+
+static const saul_private_ops_table saul_private_tables[] = {
+    [SAUL_ISA_SCALAR] = {
+        SAUL_ISA_SCALAR, saul_private_kernel_scalar, saul_private_add_scalar, saul_private_sub_scalar, saul_private_axpy_scalar,
+        saul_private_scale_scalar, saul_private_clamp_scalar, saul_private_relu_scalar, saul_private_exp_scalar
+    },
+#ifdef SAUL_X86
+    [SAUL_ISA_SSE2] = {
+        SAUL_ISA_SSE2, saul_private_kernel_sse2, saul_private_add_sse2, saul_private_sub_sse2, saul_private_axpy_sse2,
+        saul_private_scale_sse2, saul_private_clamp_sse2, saul_private_relu_sse2, saul_private_exp_sse2
+    },
+    [SAUL_ISA_AVX2] = {
+        SAUL_ISA_AVX2, saul_private_kernel_avx2, saul_private_add_avx2, saul_private_sub_avx2, saul_private_axpy_avx2,
+        saul_private_scale_avx2, saul_private_clamp_avx2, saul_private_relu_avx2, saul_private_exp_avx2
+    },
+    [SAUL_ISA_AVX512] = {
+        SAUL_ISA_AVX512, saul_private_kernel_avx512, saul_private_add_avx512, saul_private_sub_avx512, saul_private_axpy_avx512,
+        saul_private_scale_avx512, saul_private_clamp_avx512, saul_private_relu_avx512, saul_private_exp_avx512
+    },
+#endif
+};
+
+// The active table is published with one atomic store, so a thread never
+// sees half of one ISA and half of another; NULL until the first init
+static _Atomic(const saul_private_ops_table *) saul_private_active;
+static pthread_once_t saul_private_once = PTHREAD_ONCE_INIT;
+
+static int saul_private_isa_supported(saul_isa isa) {
+    switch(isa) {
+    case SAUL_ISA_SCALAR:
+        return 1;
+#ifdef SAUL_X86
+    case SAUL_ISA_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case SAUL_ISA_AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case SAUL_ISA_AVX512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return 0;
+    }
+}
+
+int saul_set_isa(saul_isa isa) {
+#ifdef SAUL_X86
+    __builtin_cpu_init();
+#endif
+    if(!saul_private_isa_supported(isa)) {
         return -1;
     }
-    saul_matrix_for_each_double(m1, m2, saul_private_sub_each);
+    atomic_store_explicit(&saul_private_active, &saul_private_tables[isa], memory_order_release);
     return 0;
 }
 
-Matrix *saul_matrix_mul(Matrix *m1, Matrix *m2) {
+void saul_init(void) {
+    for(int isa = SAUL_ISA_AVX512; isa >= SAUL_ISA_SCALAR; isa--) {
+        if(saul_set_isa((saul_isa)isa) == 0) {
+            break;
+        }
+    }
+}
 
-    if(m1->cols != m2->rows) {
-        return NULL;
+// The dispatch table, resolved once on first use if saul_init() was not
+// called. Call sites load it once and take every kernel from that table
+static inline const saul_private_ops_table *saul_private_ops(void) {
+    const saul_private_ops_table *ops = atomic_load_explicit(&saul_private_active, memory_order_acquire);
+    if(ops == NULL) {
+        pthread_once(&saul_private_once, saul_init);
+        ops = atomic_load_explicit(&saul_private_active, memory_order_acquire);
     }
+    return ops;
+}
 
-    Matrix *m3 = saul_new_matrix(m1->rows, m2->cols);
+static inline void saul_private_ensure_init(void) {
+    (void)saul_private_ops();
+}
 
-    for(int i = 0; i < m1->rows; i++) {
-        for(int j = 0; j < m2->cols; j++) {
+saul_isa saul_get_isa(void) {
+    return saul_private_ops()->isa;
+}
 
-            for(int k = 0; k < m1->cols; k++) {
-                float a = saul_get_value_by_index(m1, i, k);
-                float b = saul_get_value_by_index(m2, k, j);
-                float current = saul_get_value_by_index(m3, i, j);
+// -- Thread pool
+//
+// Workers are started once and sleep on a condition variable between jobs.
+// A job is n_tasks calls of fn(ctx, task); the submitting thread takes
+// tasks too, so with n threads there are n - 1 workers. Jobs submitted
+// from inside a task run inline.
 
-                float value =  current + a * b;
-                saul_matrix_set_value(m3, i, j, value);
-            }
+#ifndef SAUL_PARALLEL_MIN
+#define SAUL_PARALLEL_MIN (1 << 16)
+#endif
+
+typedef void (*saul_private_task_fn)(void *, int);
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    pthread_mutex_t submit;
+    pthread_t *workers;
+    int n_workers;
+    atomic_int n_threads;
+    unsigned long generation;
+    int active;
+    int stop;
+    saul_private_task_fn fn;
+    void *ctx;
+    int n_tasks;
+    atomic_int next;
+} saul_private_pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+    .submit = PTHREAD_MUTEX_INITIALIZER
+};
+
+static __thread int saul_private_in_task;
 
+// Per-thread packing scratch, grown on demand and kept between calls so a
+// steady stream of same-sized products does not allocate
+static __thread float *saul_private_scratch;
+static __thread size_t saul_private_scratch_len;
+
+static float *saul_private_get_scratch(size_t len) {
+    if(len > saul_private_scratch_len) {
+        void *p = NULL;
+        if(posix_memalign(&p, 64, len * sizeof(float)) != 0) {
+            return NULL;
         }
+        free(saul_private_scratch);
+        saul_private_scratch = (float *)p;
+        saul_private_scratch_len = len;
     }
-    return m3;
+    return saul_private_scratch;
 }
 
-void saul_matrix_transpose(Matrix **m) {
-    Matrix *actual = *m;
-    Matrix *new = saul_new_matrix(actual->cols, actual->rows);
+static void saul_private_free_scratch(void) {
+    free(saul_private_scratch);
+    saul_private_scratch = NULL;
+    saul_private_scratch_len = 0;
+}
+
+static void saul_private_run_tasks(void) {
+    saul_private_in_task = 1;
+    int task;
+    while((task = atomic_fetch_add(&saul_private_pool.next, 1)) < saul_private_pool.n_tasks) {
+        saul_private_pool.fn(saul_private_pool.ctx, task);
+    }
+    saul_private_in_task = 0;
+}
+
+static void *saul_private_worker(void *arg) {
+    unsigned long seen = (unsigned long)(uintptr_t)arg;
+
+    pthread_mutex_lock(&saul_private_pool.lock);
+    for(;;) {
+        while(!saul_private_pool.stop && saul_private_pool.generation == seen) {
+            pthread_cond_wait(&saul_private_pool.wake, &saul_private_pool.lock);
+        }
+        if(saul_private_pool.stop) {
+            break;
+        }
+        seen = saul_private_pool.generation;
+        pthread_mutex_unlock(&saul_private_pool.lock);
 
-    for(int i = 0; i < actual->rows; i++) {
-        for(int j = 0; j < actual->cols; j++) {
-            float value = saul_get_value_by_index(actual, i, j);
-            saul_matrix_set_value(new, j, i, value);
+        saul_private_run_tasks();
+
+        pthread_mutex_lock(&saul_private_pool.lock);
+        if(--saul_private_pool.active == 0) {
+            pthread_cond_signal(&saul_private_pool.done);
         }
     }
+    pthread_mutex_unlock(&saul_private_pool.lock);
+    saul_private_free_scratch();
+    return NULL;
+}
 
-    *m = new;
+static void saul_private_pool_stop(void) {
+    pthread_mutex_lock(&saul_private_pool.lock);
+    saul_private_pool.stop = 1;
+    pthread_cond_broadcast(&saul_private_pool.wake);
+    pthread_mutex_unlock(&saul_private_pool.lock);
+
+    for(int t = 0; t < saul_private_pool.n_workers; t++) {
+        pthread_join(saul_private_pool.workers[t], NULL);
+    }
+    free(saul_private_pool.workers);
+    saul_private_pool.workers = NULL;
+    saul_private_pool.n_workers = 0;
+    saul_private_pool.stop = 0;
 }
 
-int saul_is_upper_triangular(Matrix *m) {
-    int i = 0;
-    int j = 0;
-    while(i != m->rows && j != m->cols) {
-        for(int k = i + 1; k < m->rows; k++) {
-            float value = saul_get_value_by_index(m, k, j);
-            if (value != 0) return -1;
+int saul_set_num_threads(int n) {
+    if(n <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        n = online > 0 ? (int)online : 1;
+    }
+
+    pthread_mutex_lock(&saul_private_pool.submit);
+    saul_private_pool_stop();
+
+    int rc = 0;
+    if(n > 1) {
+        saul_private_pool.workers = (pthread_t *)malloc((size_t)(n - 1) * sizeof(pthread_t));
+        if(saul_private_pool.workers == NULL) {
+            n = 1;
+            rc = -1;
         }
-        ++i;
-        ++j;
     }
-    return 0;
+    for(int t = 0; t < n - 1; t++) {
+        void *gen = (void *)(uintptr_t)saul_private_pool.generation;
+        if(pthread_create(&saul_private_pool.workers[t], NULL, saul_private_worker, gen) != 0) {
+            rc = -1;
+            break;
+        }
+        saul_private_pool.n_workers++;
+    }
+    atomic_store_explicit(&saul_private_pool.n_threads, saul_private_pool.n_workers + 1, memory_order_relaxed);
+
+    pthread_mutex_unlock(&saul_private_pool.submit);
+    return rc;
 }
 
-// TODO: SOMETIMES IS IMPOSSIBLE TO SOLVE
-int saul_gauss_reduction(Matrix **_m) {
+int saul_get_num_threads(void) {
+    int n = atomic_load_explicit(&saul_private_pool.n_threads, memory_order_relaxed);
+    return n > 0 ? n : 1;
+}
 
-    int i = 0;
-    int j = 0;
-    Matrix *m = *_m;
+// Hands a job to the workers and takes tasks until it is done, the caller
+// holds submit and the pool has workers
+static void saul_private_pool_run(int n_tasks, saul_private_task_fn fn, void *ctx) {
+    pthread_mutex_lock(&saul_private_pool.lock);
+    saul_private_pool.fn = fn;
+    saul_private_pool.ctx = ctx;
+    saul_private_pool.n_tasks = n_tasks;
+    atomic_store(&saul_private_pool.next, 0);
+    saul_private_pool.active = saul_private_pool.n_workers;
+    saul_private_pool.generation++;
+    pthread_cond_broadcast(&saul_private_pool.wake);
+    pthread_mutex_unlock(&saul_private_pool.lock);
 
-    while(saul_is_upper_triangular(m) != 0) {
-        float pivot = saul_get_value_by_index(m, i, j);
+    saul_private_run_tasks();
 
-        for(int k = i + 1; k < m->rows; k++) {
-            float pivotBelow = saul_get_value_by_index(m, k, j);
-            for(int l = 0; l < m->cols; l++) {
-                float a = saul_get_value_by_index(m, i, l);
-                float b = saul_get_value_by_index(m, k, l);
-
-                float mul = -pivotBelow / pivot;
-                float value = mul * a + b;
-                saul_matrix_set_value(m, k, l, value);
-            }
+    pthread_mutex_lock(&saul_private_pool.lock);
+    while(saul_private_pool.active > 0) {
+        pthread_cond_wait(&saul_private_pool.done, &saul_private_pool.lock);
+    }
+    pthread_mutex_unlock(&saul_private_pool.lock);
+}
+
+static void saul_private_parallel_for(int n_tasks, saul_private_task_fn fn, void *ctx) {
+    if(n_tasks > 1 && !saul_private_in_task) {
+        // saul_set_num_threads() resizes the pool under submit, so the
+        // worker count is only read while holding it
+        pthread_mutex_lock(&saul_private_pool.submit);
+        if(saul_private_pool.n_workers > 0) {
+            saul_private_pool_run(n_tasks, fn, ctx);
+            pthread_mutex_unlock(&saul_private_pool.submit);
+            return;
         }
-        ++i;
-        ++j;
+        pthread_mutex_unlock(&saul_private_pool.submit);
     }
 
-    return 0;
+    for(int task = 0; task < n_tasks; task++) {
+        fn(ctx, task);
+    }
+}
 
+// Rows per task for an elementwise op, all rows in one task below the threshold
+static int saul_private_row_tasks(int rows, int cols) {
+    size_t total = (size_t)rows * cols;
+    int threads = saul_get_num_threads();
+    if(threads == 1 || total < SAUL_PARALLEL_MIN) {
+        return 1;
+    }
+    size_t tasks = total / (SAUL_PARALLEL_MIN / 4);
+    if(tasks > (size_t)threads * 4) tasks = (size_t)threads * 4;
+    if(tasks > (size_t)rows) tasks = (size_t)rows;
+    return tasks > 0 ? (int)tasks : 1;
 }
 
-void saul_print_matrix(Matrix *m) {
-    int col_width[m->cols];
+typedef struct {
+    Matrix *dst;
+    Matrix *a;
+    Matrix *b;
+    saul_private_ewise_fn fn;
+    int n_tasks;
+} saul_private_ewise_job;
 
-    for(int j = 0; j < m->cols; j++) {
-        int max = 0;
-        for(int i = 0; i < m->rows; i++) {
-            char buf[64];
-            snprintf(buf, sizeof(buf), "%.2f", m->items[i][j]);
-            int len = strlen(buf);
-            if(len > max) max = len;
-        }
-        col_width[j] = max;
+static void saul_private_ewise_task(void *arg, int task) {
+    saul_private_ewise_job *job = (saul_private_ewise_job *)arg;
+    int from = (int)((long long)job->dst->rows * task / job->n_tasks);
+    int to = (int)((long long)job->dst->rows * (task + 1) / job->n_tasks);
+    for(int i = from; i < to; i++) {
+        job->fn(&SAUL_AT(job->dst, i, 0), &SAUL_AT(job->a, i, 0), &SAUL_AT(job->b, i, 0), job->dst->cols);
     }
+}
 
-    for(int i = 0; i < m->rows; i++) {
-        printf("[");
-        for(int j = 0; j < m->cols; j++) {
-            printf(" %*.*f ", col_width[j], 2, m->items[i][j]);
+static void saul_private_ewise(Matrix *dst, Matrix *a, Matrix *b, saul_private_ewise_fn fn) {
+    saul_private_ewise_job job = { dst, a, b, fn, saul_private_row_tasks(dst->rows, dst->cols) };
+    saul_private_parallel_for(job.n_tasks, saul_private_ewise_task, &job);
+}
+
+typedef struct {
+    Matrix *m;
+    Matrix *x;
+    saul_private_map_fn fn;
+    float a;
+    float b;
+    int n_tasks;
+} saul_private_map_job;
+
+static void saul_private_map_task(void *arg, int task) {
+    saul_private_map_job *job = (saul_private_map_job *)arg;
+    int from = (int)((long long)job->m->rows * task / job->n_tasks);
+    int to = (int)((long long)job->m->rows * (task + 1) / job->n_tasks);
+    saul_private_axpy_fn axpy = saul_private_ops()->axpy;
+    for(int i = from; i < to; i++) {
+        if(job->x != NULL) {
+            axpy(&SAUL_AT(job->m, i, 0), &SAUL_AT(job->x, i, 0), job->a, job->m->cols);
+        } else {
+            job->fn(&SAUL_AT(job->m, i, 0), job->m->cols, job->a, job->b);
         }
-        printf("]\n");
     }
 }
 
+// m = fn(m) row by row, or m += a * x when x is given
+static void saul_private_map(Matrix *m, Matrix *x, saul_private_map_fn fn, float a, float b) {
+    saul_private_map_job job = { m, x, fn, a, b, saul_private_row_tasks(m->rows, m->cols) };
+    saul_private_parallel_for(job.n_tasks, saul_private_map_task, &job);
+}
 
+// Whether two rows x cols blocks of size-byte elements share any memory,
+// for any element type; strides are in elements
+static int saul_private_overlaps_bytes(const void *a, int a_rows, int a_cols, int a_stride,
+                                       const void *b, int b_rows, int b_cols, int b_stride, size_t size) {
+    if(a_rows == 0 || a_cols == 0 || b_rows == 0 || b_cols == 0) {
+        return 0;
+    }
+    uintptr_t a0 = (uintptr_t)a;
+    uintptr_t b0 = (uintptr_t)b;
+    uintptr_t a_end = a0 + ((size_t)(a_rows - 1) * a_stride + a_cols) * size;
+    uintptr_t b_end = b0 + ((size_t)(b_rows - 1) * b_stride + b_cols) * size;
+    if(a0 >= b_end || b0 >= a_end) {
+        return 0;
+    }
+    if(a_stride != b_stride) {
+        return 1;
+    }
 
-void saul_free_matrix(Matrix *m) {
-    free(m);
+    // Views of one parent: the address ranges interleave, but the blocks
+    // are disjoint if their row or column spans are
+    ptrdiff_t row = (ptrdiff_t)((size_t)a_stride * size);
+    ptrdiff_t d = (ptrdiff_t)(b0 - a0);
+    ptrdiff_t r = d >= 0 ? d / row : -((-d + row - 1) / row);
+    ptrdiff_t c = d - r * row;
+    if(c + (ptrdiff_t)(b_cols * size) > row) {
+        return 1;
+    }
+    int rows_apart = r >= a_rows || r + b_rows <= 0;
+    int cols_apart = c >= (ptrdiff_t)(a_cols * size) || c + (ptrdiff_t)(b_cols * size) <= 0;
+    return !(rows_apart || cols_apart);
+}
+
+// Whether the elements of two matrices share any memory
+static int saul_private_overlaps(Matrix *a, Matrix *b) {
+    return saul_private_overlaps_bytes(a->items, a->rows, a->cols, a->stride,
+                                       b->items, b->rows, b->cols, b->stride, sizeof(float));
+}
+
+
+// -- GEMM driver
+//
+// C is cut into macro-tiles: NC-wide column panels times row chunks (a
+// multiple of MC, one chunk per thread). Each tile is packed into the
+// running thread's scratch, so threads never share writable memory; a tile packs
+// its B panel once per KC step and reuses it for all its MC blocks.
+
+typedef struct {
+    int m, n, k;
+    float alpha;
+    const float *a;
+    int rsa, csa;
+    const float *b;
+    int rsb, csb;
+    float *c;
+    int ldc;
+    int n_ic;
+    int ic_chunk;
+    saul_private_kernel_fn kernel;
+    int failed;
+} saul_private_gemm_job;
+
+static void saul_private_gemm_task(void *arg, int task) {
+    saul_private_gemm_job *job = (saul_private_gemm_job *)arg;
+    int jc = task / job->n_ic * SAUL_GEMM_NC;
+    int nc = job->n - jc < SAUL_GEMM_NC ? job->n - jc : SAUL_GEMM_NC;
+    int i0 = task % job->n_ic * job->ic_chunk;
+    int i1 = i0 + job->ic_chunk < job->m ? i0 + job->ic_chunk : job->m;
+    if(i0 >= i1) {
+        return;
+    }
+
+    int mc_max = i1 - i0 < SAUL_GEMM_MC ? i1 - i0 : SAUL_GEMM_MC;
+    int kc_max = job->k < SAUL_GEMM_KC ? job->k : SAUL_GEMM_KC;
+    size_t a_len = (size_t)(mc_max + SAUL_GEMM_MR - 1) / SAUL_GEMM_MR * SAUL_GEMM_MR * kc_max;
+    size_t b_len = (size_t)(nc + SAUL_GEMM_NR - 1) / SAUL_GEMM_NR * SAUL_GEMM_NR * kc_max;
+    a_len = (a_len + 15) & ~(size_t)15;
+
+    float *pa = saul_private_get_scratch(a_len + b_len);
+    if(pa == NULL) {
+        job->failed = 1;
+        return;
+    }
+    float *pb = pa + a_len;
+
+    for(int pc = 0; pc < job->k; pc += SAUL_GEMM_KC) {
+        int kc = job->k - pc < SAUL_GEMM_KC ? job->k - pc : SAUL_GEMM_KC;
+        saul_private_pack_b(kc, nc, job->b + (size_t)pc * job->rsb + (size_t)jc * job->csb, job->rsb, job->csb, (float *)pb);
+
+        for(int ic = i0; ic < i1; ic += SAUL_GEMM_MC) {
+            int mc = i1 - ic < SAUL_GEMM_MC ? i1 - ic : SAUL_GEMM_MC;
+            saul_private_pack_a(mc, kc, job->a + (size_t)ic * job->rsa + (size_t)pc * job->csa, job->rsa, job->csa,
+                                job->alpha, (float *)pa);
+
+            for(int jr = 0; jr < nc; jr += SAUL_GEMM_NR) {
+                int nr = nc - jr < SAUL_GEMM_NR ? nc - jr : SAUL_GEMM_NR;
+                const float *bs = (const float *)pb + (size_t)jr * kc;
+
+                for(int ir = 0; ir < mc; ir += SAUL_GEMM_MR) {
+                    int mr = mc - ir < SAUL_GEMM_MR ? mc - ir : SAUL_GEMM_MR;
+                    const float *as = (const float *)pa + (size_t)ir * kc;
+                    float *cs = job->c + (size_t)(ic + ir) * job->ldc + jc + jr;
+                    job->kernel(kc, as, bs, cs, job->ldc, mr, nr);
+                }
+            }
+        }
+    }
 }
 
+// C = alpha * A * B + beta * C, A is m x k and B is k x n given by row and
+// column strides (so transposes are free), C is row-major with stride ldc
+static int saul_private_gemm(int m, int n, int k, float alpha,
+                             const float *a, int rsa, int csa,
+                             const float *b, int rsb, int csb,
+                             float beta, float *c, int ldc) {
+    if(beta != 1.0f) {
+        for(int i = 0; i < m; i++) {
+            float *row = c + (size_t)i * ldc;
+            for(int j = 0; j < n; j++) {
+                row[j] = beta == 0.0f ? 0.0f : beta * row[j];
+            }
+        }
+    }
+    if(alpha == 0.0f || k == 0 || m == 0 || n == 0) {
+        return 0;
+    }
+
+    saul_private_ensure_init();
+
+    // Small products stay on the calling thread
+    int threads = (double)m * n * k < (double)SAUL_PARALLEL_MIN * 64 ? 1 : saul_get_num_threads();
+    int n_jc = (n + SAUL_GEMM_NC - 1) / SAUL_GEMM_NC;
+    int n_ic = threads > n_jc ? (threads + n_jc - 1) / n_jc : 1;
+    int ic_chunk = (m + n_ic - 1) / n_ic;
+    ic_chunk = (ic_chunk + SAUL_GEMM_MR - 1) / SAUL_GEMM_MR * SAUL_GEMM_MR;
+    n_ic = (m + ic_chunk - 1) / ic_chunk;
+
+    saul_private_gemm_job job = {
+        m, n, k, alpha, a, rsa, csa, b, rsb, csb, c, ldc, n_ic, ic_chunk, saul_private_ops()->kernel, 0
+    };
+    saul_private_parallel_for(n_jc * n_ic, saul_private_gemm_task, &job);
+    return job.failed ? -1 : 0;
+}
+
+
+// -- Factorizations
+//
+// Blocked and right-looking: factor a narrow panel with plain loops, then
+// push its effect onto the trailing matrix with one saul_private_gemm, so
+// nearly all of the O(n^3) work runs in the GEMM kernels.
+
+#ifndef SAUL_LU_NB
+#define SAUL_LU_NB 64
+#endif
+
+static void saul_private_swap_rows(float *x, float *y, int n) {
+    for(int j = 0; j < n; j++) {
+        float t = x[j];
+        x[j] = y[j];
+        y[j] = t;
+    }
+}
+
+// row_y -= s * row_x
+static void saul_private_row_axpy(float *y, const float *x, float s, int n) {
+    saul_private_ops()->axpy(y, x, -s, n);
+}
+
+// Solves T X = B in place. T is n x n triangular, given by row and column
+// strides so T^T costs nothing; B is n x nrhs with row stride ldb. Blocks
+// of SAUL_LU_NB rows first take the update from the solved rows by GEMM.
+static void saul_private_trsm(int lower, int unit, int n, int nrhs,
+                              const float *t, int rst, int cst, float *b, int ldb) {
+    if(lower) {
+        for(int i0 = 0; i0 < n; i0 += SAUL_LU_NB) {
+            int i1 = i0 + SAUL_LU_NB < n ? i0 + SAUL_LU_NB : n;
+            saul_private_gemm(i1 - i0, nrhs, i0, -1.0f, t + (size_t)i0 * rst, rst, cst,
+                              b, ldb, 1, 1.0f, b + (size_t)i0 * ldb, ldb);
+            for(int i = i0; i < i1; i++) {
+                float *row = b + (size_t)i * ldb;
+                for(int j = i0; j < i; j++) {
+                    saul_private_row_axpy(row, b + (size_t)j * ldb, t[(size_t)i * rst + (size_t)j * cst], nrhs);
+                }
+                if(!unit) {
+                    float inv = 1.0f / t[(size_t)i * rst + (size_t)i * cst];
+                    for(int j = 0; j < nrhs; j++) row[j] *= inv;
+                }
+            }
+        }
+        return;
+    }
+
+    for(int i1 = n; i1 > 0; i1 -= SAUL_LU_NB) {
+        int i0 = i1 - SAUL_LU_NB > 0 ? i1 - SAUL_LU_NB : 0;
+        saul_private_gemm(i1 - i0, nrhs, n - i1, -1.0f, t + (size_t)i0 * rst + (size_t)i1 * cst, rst, cst,
+                          b + (size_t)i1 * ldb, ldb, 1, 1.0f, b + (size_t)i0 * ldb, ldb);
+        for(int i = i1 - 1; i >= i0; i--) {
+            float *row = b + (size_t)i * ldb;
+            for(int j = i + 1; j < i1; j++) {
+                saul_private_row_axpy(row, b + (size_t)j * ldb, t[(size_t)i * rst + (size_t)j * cst], nrhs);
+            }
+            if(!unit) {
+                float inv = 1.0f / t[(size_t)i * rst + (size_t)i * cst];
+                for(int j = 0; j < nrhs; j++) row[j] *= inv;
+            }
+        }
+    }
+}
+
+// Factors columns j0..j1 of rows j0..n in place, swapping whole rows (rows
+// are contiguous, so this is cheap and needs no separate laswp pass). It
+// splits in halves down to 8 columns, so even the panel is mostly GEMM.
+// Returns 1 if a pivot was zero.
+static int saul_private_lu_panel(Matrix *a, int *piv, int j0, int j1) {
+    int n = a->rows;
+    int ld = a->stride;
+
+    if(j1 - j0 > 8) {
+        int jm = j0 + (j1 - j0) / 2;
+        int singular = saul_private_lu_panel(a, piv, j0, jm);
+        saul_private_trsm(1, 1, jm - j0, j1 - jm, &SAUL_AT(a, j0, j0), ld, 1, &SAUL_AT(a, j0, jm), ld);
+        saul_private_gemm(n - jm, j1 - jm, jm - j0, -1.0f, &SAUL_AT(a, jm, j0), ld, 1,
+                          &SAUL_AT(a, j0, jm), ld, 1, 1.0f, &SAUL_AT(a, jm, jm), ld);
+        return saul_private_lu_panel(a, piv, jm, j1) | singular;
+    }
+
+    int singular = 0;
+    for(int j = j0; j < j1; j++) {
+        int p = j;
+        float best = fabsf(SAUL_AT(a, j, j));
+        for(int i = j + 1; i < n; i++) {
+            float v = fabsf(SAUL_AT(a, i, j));
+            if(v > best) {
+                best = v;
+                p = i;
+            }
+        }
+        piv[j] = p;
+        if(p != j) {
+            saul_private_swap_rows(&SAUL_AT(a, j, 0), &SAUL_AT(a, p, 0), a->cols);
+        }
+        if(best == 0.0f) {
+            singular = 1;
+            continue;
+        }
+
+        float inv = 1.0f / SAUL_AT(a, j, j);
+        for(int i = j + 1; i < n; i++) {
+            SAUL_AT(a, i, j) *= inv;
+            saul_private_row_axpy(&SAUL_AT(a, i, j + 1), &SAUL_AT(a, j, j + 1), SAUL_AT(a, i, j), j1 - j - 1);
+        }
+    }
+    return singular;
+}
+
+// Eight independent partial sums, so the compiler can keep them in one
+// vector register instead of a serial chain of adds
+static float saul_private_dot(const float *x, const float *y, int n) {
+    float acc[8] = { 0 };
+    int j = 0;
+    for(; j + 8 <= n; j += 8) {
+        for(int l = 0; l < 8; l++) {
+            acc[l] += x[j + l] * y[j + l];
+        }
+    }
+    float s = ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+    for(; j < n; j++) {
+        s += x[j] * y[j];
+    }
+    return s;
+}
+
+// -- Householder QR
+//
+// Reflectors are stored LAPACK style: v_j lives below the diagonal of
+// column j with an implicit 1 on it, tau[j] beside. A panel of kb of them
+// is applied at once as Q^T = I - V T^T V^T (compact WY), which is three
+// GEMMs instead of kb rank-1 updates.
+
+// Scratch for saul_private_qr_apply on an m-row matrix with up to nc columns
+static size_t saul_private_qr_work_len(int m, int nc) {
+    size_t ld = SAUL_LU_NB;
+    size_t ldw = (size_t)(nc + SAUL_ALIGN - 1) / SAUL_ALIGN * SAUL_ALIGN;
+    return (size_t)m * ld + 2 * ld * ld + 2 * ld * ldw;
+}
+
+// C = Q^T C for the reflectors in columns k0..k0+kb of a; C holds rows
+// k0..m with row stride ldc
+static void saul_private_qr_apply(Matrix *a, const float *tau, int k0, int kb,
+                                  float *c, int ldc, int nc, float *work) {
+    int mv = a->rows - k0;
+    int ld = SAUL_LU_NB;
+    int ldw = (nc + SAUL_ALIGN - 1) / SAUL_ALIGN * SAUL_ALIGN;
+    float *v = work;
+    float *t = v + (size_t)mv * ld;
+    float *s = t + (size_t)ld * ld;
+    float *w = s + (size_t)ld * ld;
+    float *w2 = w + (size_t)ld * ldw;
+
+    // V with its unit diagonal and zeros above made explicit
+    for(int i = 0; i < mv; i++) {
+        float *row = v + (size_t)i * ld;
+        for(int j = 0; j < kb; j++) {
+            row[j] = i > j ? SAUL_AT(a, k0 + i, k0 + j) : (i == j ? 1.0f : 0.0f);
+        }
+    }
+
+    // T from S = V^T V: T[0:j, j] = -tau_j T[0:j, 0:j] S[0:j, j]
+    saul_private_gemm(kb, kb, mv, 1.0f, v, 1, ld, v, ld, 1, 0.0f, s, ld);
+    memset(t, 0, (size_t)ld * ld * sizeof(float));
+    for(int j = 0; j < kb; j++) {
+        float tj = tau[k0 + j];
+        t[(size_t)j * ld + j] = tj;
+        for(int i = 0; i < j; i++) {
+            float sum = 0.0f;
+            for(int l = i; l < j; l++) {
+                sum += t[(size_t)i * ld + l] * s[(size_t)l * ld + j];
+            }
+            t[(size_t)i * ld + j] = -tj * sum;
+        }
+    }
+
+    // W = V^T C, W2 = T^T W, C -= V W2
+    saul_private_gemm(kb, nc, mv, 1.0f, v, 1, ld, c, ldc, 1, 0.0f, w, ldw);
+    saul_private_gemm(kb, nc, kb, 1.0f, t, 1, ld, w, ldw, 1, 0.0f, w2, ldw);
+    saul_private_gemm(mv, nc, kb, -1.0f, v, ld, 1, w2, ldw, 1, 1.0f, c, ldc);
+}
+
+// Unblocked QR of columns k0..k1, rows k0..m
+static void saul_private_qr_panel(Matrix *a, float *tau, int k0, int k1) {
+    int m = a->rows;
+    float wv[SAUL_LU_NB];
+    saul_private_axpy_fn axpy = saul_private_ops()->axpy;
+
+    for(int j = k0; j < k1; j++) {
+        double sigma = 0.0;
+        for(int i = j + 1; i < m; i++) {
+            sigma += (double)SAUL_AT(a, i, j) * SAUL_AT(a, i, j);
+        }
+        float alpha = SAUL_AT(a, j, j);
+        if(sigma == 0.0) {
+            tau[j] = 0.0f;
+            continue;
+        }
+
+        float beta = (float)-copysign(sqrt((double)alpha * alpha + sigma), alpha);
+        tau[j] = (beta - alpha) / beta;
+        float scale = 1.0f / (alpha - beta);
+        for(int i = j + 1; i < m; i++) {
+            SAUL_AT(a, i, j) *= scale;
+        }
+        SAUL_AT(a, j, j) = beta;
+
+        // Rest of the panel: w = v^T A, A -= tau v w^T
+        int nw = k1 - j - 1;
+        if(nw == 0) {
+            continue;
+        }
+        memcpy(wv, &SAUL_AT(a, j, j + 1), (size_t)nw * sizeof(float));
+        for(int i = j + 1; i < m; i++) {
+            axpy(wv, &SAUL_AT(a, i, j + 1), SAUL_AT(a, i, j), nw);
+        }
+        axpy(&SAUL_AT(a, j, j + 1), wv, -tau[j], nw);
+        for(int i = j + 1; i < m; i++) {
+            axpy(&SAUL_AT(a, i, j + 1), wv, -tau[j] * SAUL_AT(a, i, j), nw);
+        }
+    }
+}
+
+// -- Sparse
+//
+// CSR kernels are split over the pool by nonzeros rather than rows, so a
+// few dense rows (hubs in a graph) don't leave the other threads idle.
+
+static SparseMatrix *saul_private_sparse_alloc(int rows, int cols, int nnz, saul_sparse_format format) {
+    SparseMatrix *s = (SparseMatrix *)malloc(sizeof(SparseMatrix));
+    if(s == NULL) {
+        return NULL;
+    }
+    int major = format == SAUL_CSR ? rows : cols;
+    s->rows = rows;
+    s->cols = cols;
+    s->nnz = nnz;
+    s->format = format;
+    s->ptr = (int *)calloc((size_t)major + 1, sizeof(int));
+    s->idx = (int *)malloc((size_t)(nnz > 0 ? nnz : 1) * sizeof(int));
+    s->values = (float *)malloc((size_t)(nnz > 0 ? nnz : 1) * sizeof(float));
+    if(s->ptr == NULL || s->idx == NULL || s->values == NULL) {
+        saul_sparse_free(s);
+        return NULL;
+    }
+    return s;
+}
+
+typedef struct {
+    SparseMatrix *a;
+    const float *x;
+    float *y;
+    Matrix *b;
+    Matrix *c;
+    int n_tasks;
+} saul_private_sparse_job;
+
+// First row of a task's share of the nonzeros
+static int saul_private_sparse_split(SparseMatrix *a, int task, int n_tasks) {
+    if(task == n_tasks) {
+        return a->rows;
+    }
+    int target = (int)((long long)a->nnz * task / n_tasks);
+    int lo = 0;
+    int hi = a->rows;
+    while(lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if(a->ptr[mid] < target) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static void saul_private_spmv_task(void *arg, int task) {
+    saul_private_sparse_job *job = (saul_private_sparse_job *)arg;
+    SparseMatrix *a = job->a;
+    int from = saul_private_sparse_split(a, task, job->n_tasks);
+    int to = saul_private_sparse_split(a, task + 1, job->n_tasks);
+
+    for(int i = from; i < to; i++) {
+        // Four chains so the gathers from x overlap
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+        int k = a->ptr[i];
+        int end = a->ptr[i + 1];
+        for(; k + 4 <= end; k += 4) {
+            s0 += a->values[k] * job->x[a->idx[k]];
+            s1 += a->values[k + 1] * job->x[a->idx[k + 1]];
+            s2 += a->values[k + 2] * job->x[a->idx[k + 2]];
+            s3 += a->values[k + 3] * job->x[a->idx[k + 3]];
+        }
+        for(; k < end; k++) {
+            s0 += a->values[k] * job->x[a->idx[k]];
+        }
+        job->y[i] = (s0 + s1) + (s2 + s3);
+    }
+}
+
+static void saul_private_spmm_task(void *arg, int task) {
+    saul_private_sparse_job *job = (saul_private_sparse_job *)arg;
+    SparseMatrix *a = job->a;
+    int from = saul_private_sparse_split(a, task, job->n_tasks);
+    int to = saul_private_sparse_split(a, task + 1, job->n_tasks);
+    int n = job->c->cols;
+    saul_private_axpy_fn axpy = saul_private_ops()->axpy;
+
+    for(int i = from; i < to; i++) {
+        float *row = &SAUL_AT(job->c, i, 0);
+        memset(row, 0, (size_t)n * sizeof(float));
+        for(int k = a->ptr[i]; k < a->ptr[i + 1]; k++) {
+            axpy(row, &SAUL_AT(job->b, a->idx[k], 0), a->values[k], n);
+        }
+    }
+}
+
+static int saul_private_sparse_tasks(SparseMatrix *a, int width) {
+    int per_row = a->rows > 0 ? (int)(((long long)a->nnz * width + a->rows - 1) / a->rows) : 1;
+    return saul_private_row_tasks(a->rows, per_row > 0 ? per_row : 1);
+}
+
+static void saul_private_copy(Matrix *dst, Matrix *src) {
+    for(int i = 0; i < src->rows; i++) {
+        memcpy(&SAUL_AT(dst, i, 0), &SAUL_AT(src, i, 0), (size_t)src->cols * sizeof(float));
+    }
+}
+// ---------------------------------------
+
+
+int saul_matrix_add_into(Matrix *a, Matrix *b, Matrix *out) {
+    if(a->rows != b->rows || a->cols != b->cols || out->rows != a->rows || out->cols != a->cols) {
+        return -1;
+    }
+    saul_private_ensure_init();
+    saul_private_ewise(out, a, b, saul_private_ops()->add);
+    return 0;
+}
+
+int saul_matrix_sub_into(Matrix *a, Matrix *b, Matrix *out) {
+    if(a->rows != b->rows || a->cols != b->cols || out->rows != a->rows || out->cols != a->cols) {
+        return -1;
+    }
+    saul_private_ensure_init();
+    saul_private_ewise(out, a, b, saul_private_ops()->sub);
+    return 0;
+}
+
+int saul_matrix_add(Matrix *m1, Matrix *m2) {
+    return saul_matrix_add_into(m1, m2, m1);
+}
+
+void saul_matrix_scale(Matrix *m, float alpha) {
+    saul_private_ensure_init();
+    saul_private_map(m, NULL, saul_private_ops()->scale, alpha, 0.0f);
+}
+
+int saul_matrix_axpy(float alpha, Matrix *x, Matrix *y) {
+    if(x->rows != y->rows || x->cols != y->cols) {
+        return -1;
+    }
+    // The axpy kernels take restrict rows: y += alpha * y is a scale, and
+    // any other overlap has no in-place answer
+    if(x->items == y->items && x->stride == y->stride) {
+        saul_matrix_scale(y, 1.0f + alpha);
+        return 0;
+    }
+    if(saul_private_overlaps(x, y)) {
+        return -1;
+    }
+    saul_private_ensure_init();
+    saul_private_map(y, x, NULL, alpha, 0.0f);
+    return 0;
+}
+
+void saul_matrix_clamp(Matrix *m, float lo, float hi) {
+    saul_private_ensure_init();
+    saul_private_map(m, NULL, saul_private_ops()->clamp, lo, hi);
+}
+
+void saul_matrix_relu(Matrix *m) {
+    saul_private_ensure_init();
+    saul_private_map(m, NULL, saul_private_ops()->relu, 0.0f, 0.0f);
+}
+
+void saul_matrix_exp(Matrix *m) {
+    saul_private_ensure_init();
+    saul_private_map(m, NULL, saul_private_ops()->exp, 0.0f, 0.0f);
+}
+
+int saul_matrix_sub(Matrix *m1, Matrix *m2) {
+    return saul_matrix_sub_into(m1, m2, m1);
+}
+
+int saul_gemm(float alpha, Matrix *a, int trans_a, Matrix *b, int trans_b, float beta, Matrix *c) {
+    int m = trans_a ? a->cols : a->rows;
+    int k = trans_a ? a->rows : a->cols;
+    int kb = trans_b ? b->cols : b->rows;
+    int n = trans_b ? b->rows : b->cols;
+
+    if(k != kb || c->rows != m || c->cols != n) {
+        return -1;
+    }
+    if(saul_private_overlaps(c, a) || saul_private_overlaps(c, b)) {
+        return -1;
+    }
+
+    // A transpose is the same buffer read with swapped strides
+    int rsa = trans_a ? 1 : a->stride;
+    int csa = trans_a ? a->stride : 1;
+    int rsb = trans_b ? 1 : b->stride;
+    int csb = trans_b ? b->stride : 1;
+    return saul_private_gemm(m, n, k, alpha, a->items, rsa, csa, b->items, rsb, csb, beta, c->items, c->stride);
+}
+
+int saul_matrix_mul_into(Matrix *a, Matrix *b, Matrix *out) {
+    return saul_gemm(1.0f, a, SAUL_NO_TRANS, b, SAUL_NO_TRANS, 0.0f, out);
+}
+
+Matrix *saul_matrix_mul(Matrix *m1, Matrix *m2) {
+
+    if(m1->cols != m2->rows) {
+        return NULL;
+    }
+
+    Matrix *m3 = saul_new_matrix(m1->rows, m2->cols);
+    if(m3 == NULL) {
+        return NULL;
+    }
+
+    if(saul_matrix_mul_into(m1, m2, m3) < 0) {
+        saul_free_matrix(m3);
+        return NULL;
+    }
+    return m3;
+}
+
+#define SAUL_TRANSPOSE_BLOCK 32
+
+int saul_matrix_transpose_into(Matrix *m, Matrix *out) {
+    if(out->rows != m->cols || out->cols != m->rows || saul_private_overlaps(m, out)) {
+        return -1;
+    }
+
+    // Square tiles so both the reads and the scattered writes stay in cache
+    for(int i0 = 0; i0 < m->rows; i0 += SAUL_TRANSPOSE_BLOCK) {
+        int i1 = i0 + SAUL_TRANSPOSE_BLOCK < m->rows ? i0 + SAUL_TRANSPOSE_BLOCK : m->rows;
+        for(int j0 = 0; j0 < m->cols; j0 += SAUL_TRANSPOSE_BLOCK) {
+            int j1 = j0 + SAUL_TRANSPOSE_BLOCK < m->cols ? j0 + SAUL_TRANSPOSE_BLOCK : m->cols;
+            for(int i = i0; i < i1; i++) {
+                const float *row = &SAUL_AT(m, i, 0);
+                for(int j = j0; j < j1; j++) {
+                    SAUL_AT(out, j, i) = row[j];
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int saul_matrix_transpose(Matrix **m) {
+    Matrix *actual = *m;
+    // A view cannot be reshaped without its parent, and freeing a stack
+    // header from saul_view_into() is undefined
+    if(!actual->owns_items) {
+        return -1;
+    }
+    Matrix *new = saul_new_matrix(actual->cols, actual->rows);
+    if(new == NULL) {
+        return -1;
+    }
+
+    saul_matrix_transpose_into(actual, new);
+    saul_free_matrix(actual);
+    *m = new;
+    return 0;
+}
+
+int saul_lu(Matrix *a, int *piv) {
+    if(a->rows != a->cols || piv == NULL) {
+        return -1;
+    }
+    saul_private_ensure_init();
+
+    int n = a->rows;
+    int ld = a->stride;
+    int singular = 0;
+
+    for(int k0 = 0; k0 < n; k0 += SAUL_LU_NB) {
+        int k1 = k0 + SAUL_LU_NB < n ? k0 + SAUL_LU_NB : n;
+
+        singular |= saul_private_lu_panel(a, piv, k0, k1);
+        if(k1 == n) {
+            break;
+        }
+
+        // U12 = L11^-1 A12, then A22 -= L21 U12
+        saul_private_trsm(1, 1, k1 - k0, n - k1, &SAUL_AT(a, k0, k0), ld, 1, &SAUL_AT(a, k0, k1), ld);
+        saul_private_gemm(n - k1, n - k1, k1 - k0, -1.0f, &SAUL_AT(a, k1, k0), ld, 1,
+                          &SAUL_AT(a, k0, k1), ld, 1, 1.0f, &SAUL_AT(a, k1, k1), ld);
+    }
+
+    return singular ? -2 : 0;
+}
+
+int saul_lu_solve(Matrix *lu, const int *piv, Matrix *b) {
+    if(lu->rows != lu->cols || b->rows != lu->rows || piv == NULL) {
+        return -1;
+    }
+    saul_private_ensure_init();
+
+    int n = lu->rows;
+    for(int i = 0; i < n; i++) {
+        if(SAUL_AT(lu, i, i) == 0.0f) {
+            return -2;
+        }
+    }
+    for(int i = 0; i < n; i++) {
+        if(piv[i] != i) {
+            saul_private_swap_rows(&SAUL_AT(b, i, 0), &SAUL_AT(b, piv[i], 0), b->cols);
+        }
+    }
+    saul_private_trsm(1, 1, n, b->cols, lu->items, lu->stride, 1, b->items, b->stride);
+    saul_private_trsm(0, 0, n, b->cols, lu->items, lu->stride, 1, b->items, b->stride);
+    return 0;
+}
+
+float saul_det(Matrix *m) {
+    if(m->rows != m->cols) {
+        return NAN;
+    }
+
+    Matrix *lu = saul_new_matrix(m->rows, m->cols);
+    int *piv = (int *)malloc((size_t)(m->rows > 0 ? m->rows : 1) * sizeof(int));
+    if(lu == NULL || piv == NULL) {
+        saul_free_matrix(lu);
+        free(piv);
+        return NAN;
+    }
+
+    saul_private_copy(lu, m);
+    double det = 1.0;
+    if(saul_lu(lu, piv) == 0) {
+        for(int i = 0; i < lu->rows; i++) {
+            det *= piv[i] != i ? -SAUL_AT(lu, i, i) : SAUL_AT(lu, i, i);
+        }
+    } else {
+        det = 0.0;
+    }
+
+    saul_free_matrix(lu);
+    free(piv);
+    return (float)det;
+}
+
+Matrix *saul_inverse(Matrix *m) {
+    if(m->rows != m->cols) {
+        return NULL;
+    }
+
+    int n = m->rows;
+    Matrix *lu = saul_new_matrix(n, n);
+    Matrix *inv = saul_new_matrix(n, n);
+    int *piv = (int *)malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    if(lu == NULL || inv == NULL || piv == NULL) {
+        saul_free_matrix(lu);
+        saul_free_matrix(inv);
+        free(piv);
+        return NULL;
+    }
+
+    saul_private_copy(lu, m);
+    for(int i = 0; i < n; i++) {
+        SAUL_AT(inv, i, i) = 1.0f;
+    }
+    if(saul_lu(lu, piv) != 0 || saul_lu_solve(lu, piv, inv) != 0) {
+        saul_free_matrix(inv);
+        inv = NULL;
+    }
+
+    saul_free_matrix(lu);
+    free(piv);
+    return inv;
+}
+
+int saul_cholesky(Matrix *a) {
+    if(a->rows != a->cols) {
+        return -1;
+    }
+    saul_private_ensure_init();
+
+    int n = a->rows;
+    int ld = a->stride;
+    // A diagonal-block tile for the update and room for one transposed L21
+    int ldp = (n + SAUL_ALIGN - 1) / SAUL_ALIGN * SAUL_ALIGN;
+    // Single-block factorizations never update A22 and need neither
+    float *tile = NULL;
+    float *panel = NULL;
+    if(n > SAUL_LU_NB) {
+        if(posix_memalign((void **)&tile, 64, (size_t)SAUL_LU_NB * (SAUL_LU_NB + ldp) * sizeof(float)) != 0) {
+            return -1;
+        }
+        panel = tile + SAUL_LU_NB * SAUL_LU_NB;
+    }
+
+    for(int k0 = 0; k0 < n; k0 += SAUL_LU_NB) {
+        int k1 = k0 + SAUL_LU_NB < n ? k0 + SAUL_LU_NB : n;
+        int kb = k1 - k0;
+
+        // L11: left-looking inside the block, every dot runs along rows
+        for(int j = k0; j < k1; j++) {
+            float *rj = &SAUL_AT(a, j, k0);
+            float d = SAUL_AT(a, j, j) - saul_private_dot(rj, rj, j - k0);
+            if(!(d > 0.0f)) {
+                free(tile);
+                return -2;
+            }
+            d = sqrtf(d);
+            SAUL_AT(a, j, j) = d;
+            for(int i = j + 1; i < k1; i++) {
+                SAUL_AT(a, i, j) = (SAUL_AT(a, i, j) - saul_private_dot(&SAUL_AT(a, i, k0), rj, j - k0)) / d;
+            }
+        }
+        if(k1 == n) {
+            break;
+        }
+
+        // L21 = A21 L11^-T, solved as L21^T = L11^-1 A21^T on a transposed
+        // copy so the substitution runs along long contiguous rows
+        int m2 = n - k1;
+        for(int i = 0; i < m2; i++) {
+            for(int j = 0; j < kb; j++) {
+                panel[(size_t)j * ldp + i] = SAUL_AT(a, k1 + i, k0 + j);
+            }
+        }
+        saul_private_trsm(1, 0, kb, m2, &SAUL_AT(a, k0, k0), ld, 1, panel, ldp);
+        for(int i = 0; i < m2; i++) {
+            for(int j = 0; j < kb; j++) {
+                SAUL_AT(a, k1 + i, k0 + j) = panel[(size_t)j * ldp + i];
+            }
+        }
+
+        // A22 -= L21 L21^T, lower half only: below-diagonal strips go
+        // straight through GEMM, each diagonal block through a scratch tile
+        // so the upper triangle is never written
+        for(int jb = k1; jb < n; jb += SAUL_LU_NB) {
+            int w = jb + SAUL_LU_NB < n ? SAUL_LU_NB : n - jb;
+            const float *lj = &SAUL_AT(a, jb, k0);
+
+            saul_private_gemm(w, w, kb, 1.0f, lj, ld, 1, lj, 1, ld, 0.0f, tile, SAUL_LU_NB);
+            for(int i = 0; i < w; i++) {
+                for(int j = 0; j <= i; j++) {
+                    SAUL_AT(a, jb + i, jb + j) -= tile[i * SAUL_LU_NB + j];
+                }
+            }
+            if(jb + w < n) {
+                saul_private_gemm(n - jb - w, w, kb, -1.0f, &SAUL_AT(a, jb + w, k0), ld, 1, lj, 1, ld,
+                                  1.0f, &SAUL_AT(a, jb + w, jb), ld);
+            }
+        }
+    }
+
+    free(tile);
+    return 0;
+}
+
+int saul_cholesky_solve(Matrix *l, Matrix *b) {
+    if(l->rows != l->cols || b->rows != l->rows) {
+        return -1;
+    }
+    saul_private_ensure_init();
+    for(int i = 0; i < l->rows; i++) {
+        if(!(SAUL_AT(l, i, i) > 0.0f)) {
+            return -2;
+        }
+    }
+
+    // L Y = B, then L^T X = Y reading L with swapped strides
+    saul_private_trsm(1, 0, l->rows, b->cols, l->items, l->stride, 1, b->items, b->stride);
+    saul_private_trsm(0, 0, l->rows, b->cols, l->items, 1, l->stride, b->items, b->stride);
+    return 0;
+}
+
+int saul_qr(Matrix *a, float *tau) {
+    if(tau == NULL) {
+        return -1;
+    }
+    saul_private_ensure_init();
+
+    int m = a->rows;
+    int n = a->cols;
+    int k = m < n ? m : n;
+    float *work = NULL;
+    if(posix_memalign((void **)&work, 64, saul_private_qr_work_len(m, n) * sizeof(float)) != 0) {
+        return -1;
+    }
+
+    for(int k0 = 0; k0 < k; k0 += SAUL_LU_NB) {
+        int k1 = k0 + SAUL_LU_NB < k ? k0 + SAUL_LU_NB : k;
+        saul_private_qr_panel(a, tau, k0, k1);
+        if(k1 < n) {
+            saul_private_qr_apply(a, tau, k0, k1 - k0, &SAUL_AT(a, k0, k1), a->stride, n - k1, work);
+        }
+    }
+
+    free(work);
+    return 0;
+}
+
+Matrix *saul_lstsq(Matrix *a, Matrix *b) {
+    int m = a->rows;
+    int n = a->cols;
+    if(m < n || b->rows != m) {
+        return NULL;
+    }
+
+    Matrix *qr = saul_new_matrix(m, n);
+    Matrix *qtb = saul_new_matrix(m, b->cols);
+    Matrix *x = saul_new_matrix(n, b->cols);
+    float *tau = (float *)malloc((size_t)(n > 0 ? n : 1) * sizeof(float));
+    float *work = NULL;
+    if(qr == NULL || qtb == NULL || x == NULL || tau == NULL ||
+       posix_memalign((void **)&work, 64, saul_private_qr_work_len(m, b->cols) * sizeof(float)) != 0) {
+        goto fail;
+    }
+
+    saul_private_copy(qr, a);
+    saul_private_copy(qtb, b);
+    if(saul_qr(qr, tau) != 0) {
+        goto fail;
+    }
+    // Rounding leaves a dependent column with a tiny R_ii rather than an
+    // exact zero, so compare against the largest diagonal entry
+    float rmax = 0.0f;
+    for(int i = 0; i < n; i++) {
+        rmax = fmaxf(rmax, fabsf(SAUL_AT(qr, i, i)));
+    }
+    float tol = (float)m * FLT_EPSILON * rmax;
+    for(int i = 0; i < n; i++) {
+        if(!(fabsf(SAUL_AT(qr, i, i)) > tol)) {
+            goto fail;
+        }
+    }
+
+    // X = R^-1 (Q^T B)[0:n]
+    for(int k0 = 0; k0 < n; k0 += SAUL_LU_NB) {
+        int kb = k0 + SAUL_LU_NB < n ? SAUL_LU_NB : n - k0;
+        saul_private_qr_apply(qr, tau, k0, kb, &SAUL_AT(qtb, k0, 0), qtb->stride, b->cols, work);
+    }
+    for(int i = 0; i < n; i++) {
+        memcpy(&SAUL_AT(x, i, 0), &SAUL_AT(qtb, i, 0), (size_t)b->cols * sizeof(float));
+    }
+    saul_private_trsm(0, 0, n, b->cols, qr->items, qr->stride, 1, x->items, x->stride);
+
+    saul_free_matrix(qr);
+    saul_free_matrix(qtb);
+    free(tau);
+    free(work);
+    return x;
+
+fail:
+    saul_free_matrix(qr);
+    saul_free_matrix(qtb);
+    saul_free_matrix(x);
+    free(tau);
+    free(work);
+    return NULL;
+}
+
+SparseMatrix *saul_sparse_from_coo(int rows, int cols, int nnz, const int *ri, const int *ci,
+                                   const float *values, saul_sparse_format format) {
+    if(rows < 0 || cols < 0 || nnz < 0) {
+        return NULL;
+    }
+    for(int k = 0; k < nnz; k++) {
+        if(ri[k] < 0 || ri[k] >= rows || ci[k] < 0 || ci[k] >= cols) {
+            return NULL;
+        }
+    }
+
+    const int *major = format == SAUL_CSR ? ri : ci;
+    const int *minor = format == SAUL_CSR ? ci : ri;
+    int n_major = format == SAUL_CSR ? rows : cols;
+    int n_minor = format == SAUL_CSR ? cols : rows;
+
+    SparseMatrix *s = saul_private_sparse_alloc(rows, cols, nnz, format);
+    int *count = (int *)calloc((size_t)n_minor + 1, sizeof(int));
+    int *order = (int *)malloc((size_t)(nnz > 0 ? nnz : 1) * sizeof(int));
+    if(s == NULL || count == NULL || order == NULL) {
+        saul_sparse_free(s);
+        free(count);
+        free(order);
+        return NULL;
+    }
+
+    // Two stable counting sorts, by minor then by major, leave every
+    // segment sorted with duplicates next to each other
+    for(int k = 0; k < nnz; k++) count[minor[k] + 1]++;
+    for(int i = 0; i < n_minor; i++) count[i + 1] += count[i];
+    for(int k = 0; k < nnz; k++) order[count[minor[k]]++] = k;
+
+    for(int k = 0; k < nnz; k++) s->ptr[major[k] + 1]++;
+    for(int i = 0; i < n_major; i++) s->ptr[i + 1] += s->ptr[i];
+    for(int k = 0; k < nnz; k++) {
+        int e = order[k];
+        int at = s->ptr[major[e]]++;
+        s->idx[at] = minor[e];
+        s->values[at] = values[e];
+    }
+    for(int i = n_major; i > 0; i--) s->ptr[i] = s->ptr[i - 1];
+    s->ptr[0] = 0;
+
+    // Sum duplicates in place
+    int out = 0;
+    for(int i = 0; i < n_major; i++) {
+        int start = out;
+        for(int k = s->ptr[i]; k < s->ptr[i + 1]; k++) {
+            if(out > start && s->idx[out - 1] == s->idx[k]) {
+                s->values[out - 1] += s->values[k];
+            } else {
+                s->idx[out] = s->idx[k];
+                s->values[out] = s->values[k];
+                out++;
+            }
+        }
+        s->ptr[i] = start;
+    }
+    s->ptr[n_major] = out;
+    s->nnz = out;
+
+    free(count);
+    free(order);
+    return s;
+}
+
+SparseMatrix *saul_sparse_from_dense(Matrix *m, saul_sparse_format format) {
+    int nnz = 0;
+    for(int i = 0; i < m->rows; i++) {
+        for(int j = 0; j < m->cols; j++) {
+            nnz += SAUL_AT(m, i, j) != 0.0f;
+        }
+    }
+
+    SparseMatrix *s = saul_private_sparse_alloc(m->rows, m->cols, nnz, SAUL_CSR);
+    if(s == NULL) {
+        return NULL;
+    }
+    int k = 0;
+    for(int i = 0; i < m->rows; i++) {
+        for(int j = 0; j < m->cols; j++) {
+            float v = SAUL_AT(m, i, j);
+            if(v != 0.0f) {
+                s->idx[k] = j;
+                s->values[k++] = v;
+            }
+        }
+        s->ptr[i + 1] = k;
+    }
+
+    if(format == SAUL_CSR) {
+        return s;
+    }
+    SparseMatrix *t = saul_sparse_convert(s, format);
+    saul_sparse_free(s);
+    return t;
+}
+
+SparseMatrix *saul_sparse_convert(SparseMatrix *s, saul_sparse_format format) {
+    int n_major = s->format == SAUL_CSR ? s->rows : s->cols;
+    int n_minor = s->format == SAUL_CSR ? s->cols : s->rows;
+    SparseMatrix *t = saul_private_sparse_alloc(s->rows, s->cols, s->nnz, format);
+    if(t == NULL) {
+        return NULL;
+    }
+
+    if(format == s->format) {
+        memcpy(t->ptr, s->ptr, ((size_t)n_major + 1) * sizeof(int));
+        memcpy(t->idx, s->idx, (size_t)s->nnz * sizeof(int));
+        memcpy(t->values, s->values, (size_t)s->nnz * sizeof(float));
+        return t;
+    }
+
+    // Transposing the index structure: walking majors in order keeps the
+    // new segments sorted
+    for(int k = 0; k < s->nnz; k++) t->ptr[s->idx[k] + 1]++;
+    for(int i = 0; i < n_minor; i++) t->ptr[i + 1] += t->ptr[i];
+    for(int i = 0; i < n_major; i++) {
+        for(int k = s->ptr[i]; k < s->ptr[i + 1]; k++) {
+            int at = t->ptr[s->idx[k]]++;
+            t->idx[at] = i;
+            t->values[at] = s->values[k];
+        }
+    }
+    for(int i = n_minor; i > 0; i--) t->ptr[i] = t->ptr[i - 1];
+    t->ptr[0] = 0;
+    return t;
+}
+
+Matrix *saul_sparse_to_dense(SparseMatrix *s) {
+    Matrix *m = saul_new_matrix(s->rows, s->cols);
+    if(m == NULL) {
+        return NULL;
+    }
+
+    int n_major = s->format == SAUL_CSR ? s->rows : s->cols;
+    for(int i = 0; i < n_major; i++) {
+        for(int k = s->ptr[i]; k < s->ptr[i + 1]; k++) {
+            if(s->format == SAUL_CSR) SAUL_AT(m, i, s->idx[k]) = s->values[k];
+            else SAUL_AT(m, s->idx[k], i) = s->values[k];
+        }
+    }
+    return m;
+}
+
+int saul_sparse_spmv(SparseMatrix *a, const float *x, float *y) {
+    if(a == NULL || x == NULL || y == NULL) {
+        return -1;
+    }
+
+    if(a->format == SAUL_CSC) {
+        // Scattered writes, which would race between threads
+        memset(y, 0, (size_t)a->rows * sizeof(float));
+        for(int j = 0; j < a->cols; j++) {
+            float xj = x[j];
+            for(int k = a->ptr[j]; k < a->ptr[j + 1]; k++) {
+                y[a->idx[k]] += a->values[k] * xj;
+            }
+        }
+        return 0;
+    }
+
+    saul_private_sparse_job job = { a, x, y, NULL, NULL, saul_private_sparse_tasks(a, 1) };
+    saul_private_parallel_for(job.n_tasks, saul_private_spmv_task, &job);
+    return 0;
+}
+
+int saul_sparse_spmm(SparseMatrix *a, Matrix *b, Matrix *c) {
+    if(b->rows != a->cols || c->rows != a->rows || c->cols != b->cols || saul_private_overlaps(b, c)) {
+        return -1;
+    }
+    saul_private_ensure_init();
+
+    if(a->format == SAUL_CSC) {
+        saul_private_axpy_fn axpy = saul_private_ops()->axpy;
+        for(int i = 0; i < c->rows; i++) {
+            memset(&SAUL_AT(c, i, 0), 0, (size_t)c->cols * sizeof(float));
+        }
+        for(int j = 0; j < a->cols; j++) {
+            for(int k = a->ptr[j]; k < a->ptr[j + 1]; k++) {
+                axpy(&SAUL_AT(c, a->idx[k], 0), &SAUL_AT(b, j, 0), a->values[k], c->cols);
+            }
+        }
+        return 0;
+    }
+
+    saul_private_sparse_job job = { a, NULL, NULL, b, c, saul_private_sparse_tasks(a, b->cols) };
+    saul_private_parallel_for(job.n_tasks, saul_private_spmm_task, &job);
+    return 0;
+}
+
+void saul_sparse_free(SparseMatrix *s) {
+    if(s == NULL) {
+        return;
+    }
+    free(s->ptr);
+    free(s->idx);
+    free(s->values);
+    free(s);
+}
+
+int saul_is_upper_triangular(Matrix *m) {
+    int i = 0;
+    int j = 0;
+    while(i != m->rows && j != m->cols) {
+        for(int k = i + 1; k < m->rows; k++) {
+            float value = saul_get_value_by_index(m, k, j);
+            if (value != 0) return -1;
+        }
+        ++i;
+        ++j;
+    }
+    return 0;
+}
+
+// Row echelon form with partial pivoting, in place. Columns without a
+// nonzero pivot are skipped, so it always finishes; returns the rank.
+int saul_gauss_reduction(Matrix **_m) {
+    Matrix *m = *_m;
+    int r = 0;
+    saul_private_ensure_init();
+
+    for(int j = 0; j < m->cols && r < m->rows; j++) {
+        int p = r;
+        float best = fabsf(SAUL_AT(m, r, j));
+        for(int i = r + 1; i < m->rows; i++) {
+            float v = fabsf(SAUL_AT(m, i, j));
+            if(v > best) {
+                best = v;
+                p = i;
+            }
+        }
+        if(best == 0.0f) {
+            continue;
+        }
+        if(p != r) {
+            saul_private_swap_rows(&SAUL_AT(m, r, 0), &SAUL_AT(m, p, 0), m->cols);
+        }
+
+        float inv = 1.0f / SAUL_AT(m, r, j);
+        for(int i = r + 1; i < m->rows; i++) {
+            float f = SAUL_AT(m, i, j) * inv;
+            saul_private_row_axpy(&SAUL_AT(m, i, j), &SAUL_AT(m, r, j), f, m->cols - j);
+            SAUL_AT(m, i, j) = 0.0f;
+        }
+        r++;
+    }
+
+    return r;
+}
+
+void saul_print_matrix(Matrix *m) {
+    int col_width[m->cols];
+
+    for(int j = 0; j < m->cols; j++) {
+        int max = 0;
+        for(int i = 0; i < m->rows; i++) {
+            char buf[64];
+            snprintf(buf, sizeof(buf), "%.2f", SAUL_AT(m, i, j));
+            int len = strlen(buf);
+            if(len > max) max = len;
+        }
+        col_width[j] = max;
+    }
+
+    for(int i = 0; i < m->rows; i++) {
+        printf("[");
+        for(int j = 0; j < m->cols; j++) {
+            printf(" %*.*f ", col_width[j], 2, SAUL_AT(m, i, j));
+        }
+        printf("]\n");
+    }
+}
+
+
+
+void saul_free_matrix(Matrix *m) {
+    if(m == NULL) {
+        return;
+    }
+    if(m->owns_items) {
+        free(m->items);
+    }
+    free(m);
+}
+
+
+// -- Other element types
+//
+// SAUL_DEFINE_MATRIX_TYPE stamps out a matrix type and its core API for one
+// element type, with add/sub/axpy/scale kernels compiled per ISA from GCC
+// vector types of that element. SAUL_DEFINE_SOLVERS adds LU and Cholesky
+// for floating-point types; they are row-oriented and unblocked, the packed
+// GEMM and blocked factorizations above stay float-only. Kernels compute
+// in U, the same type for floats and the unsigned one for integers, so
+// integer results wrap instead of overflowing.
+
+#ifdef SAUL_X86
+#define SAUL_PRIVATE_X86_ONLY(...) __VA_ARGS__
+#else
+#define SAUL_PRIVATE_X86_ONLY(...)
+#endif
+
+#define SAUL_PRIVATE_DEFINE_T_KERNELS(prefix, T, U, isa, attr, vec) \
+static attr void prefix##_private_add_##isa(T *dst, const T *a, const T *b, int n) { \
+    enum { W = sizeof(vec) / sizeof(T) }; \
+    int j = 0; \
+    for(; j + W <= n; j += W) { \
+        vec x, y; \
+        memcpy(&x, a + j, sizeof(x)); \
+        memcpy(&y, b + j, sizeof(y)); \
+        x = x + y; \
+        memcpy(dst + j, &x, sizeof(x)); \
+    } \
+    for(; j < n; j++) dst[j] = (T)((U)a[j] + (U)b[j]); \
+} \
+static attr void prefix##_private_sub_##isa(T *dst, const T *a, const T *b, int n) { \
+    enum { W = sizeof(vec) / sizeof(T) }; \
+    int j = 0; \
+    for(; j + W <= n; j += W) { \
+        vec x, y; \
+        memcpy(&x, a + j, sizeof(x)); \
+        memcpy(&y, b + j, sizeof(y)); \
+        x = x - y; \
+        memcpy(dst + j, &x, sizeof(x)); \
+    } \
+    for(; j < n; j++) dst[j] = (T)((U)a[j] - (U)b[j]); \
+} \
+static attr void prefix##_private_axpy_##isa(T *restrict y, const T *restrict x, T s, int n) { \
+    enum { W = sizeof(vec) / sizeof(T) }; \
+    int j = 0; \
+    for(; j + W <= n; j += W) { \
+        vec xv, yv; \
+        memcpy(&xv, x + j, sizeof(xv)); \
+        memcpy(&yv, y + j, sizeof(yv)); \
+        yv += (U)s * xv; \
+        memcpy(y + j, &yv, sizeof(yv)); \
+    } \
+    for(; j < n; j++) y[j] = (T)((U)y[j] + (U)s * (U)x[j]); \
+} \
+static attr void prefix##_private_scale_##isa(T *row, int n, T s) { \
+    enum { W = sizeof(vec) / sizeof(T) }; \
+    int j = 0; \
+    for(; j + W <= n; j += W) { \
+        vec x; \
+        memcpy(&x, row + j, sizeof(x)); \
+        x *= (U)s; \
+        memcpy(row + j, &x, sizeof(x)); \
+    } \
+    for(; j < n; j++) row[j] = (T)((U)row[j] * (U)s); \
+}
+
+#define SAUL_PRIVATE_T_TABLE(prefix, isa) \
+{ prefix##_private_add_##isa, prefix##_private_sub_##isa, prefix##_private_axpy_##isa, prefix##_private_scale_##isa }
+
+#define SAUL_DEFINE_MATRIX_TYPE(prefix, Type, T, U) \
+typedef struct { \
+    int rows; \
+    int cols; \
+    int stride; \
+    T *items; \
+    int owns_items; \
+} Type; \
+ \
+typedef void (* prefix##_row_call_back)(T *, int, void *); \
+typedef U prefix##_private_v16 __attribute__((vector_size(16))); \
+typedef U prefix##_private_v32 __attribute__((vector_size(32))); \
+typedef U prefix##_private_v64 __attribute__((vector_size(64))); \
+ \
+SAUL_PRIVATE_DEFINE_T_KERNELS(prefix, T, U, scalar, , U) \
+SAUL_PRIVATE_X86_ONLY(SAUL_PRIVATE_DEFINE_T_KERNELS(prefix, T, U, sse2, __attribute__((target("sse2"))), prefix##_private_v16)) \
+SAUL_PRIVATE_X86_ONLY(SAUL_PRIVATE_DEFINE_T_KERNELS(prefix, T, U, avx2, __attribute__((target("avx2"))), prefix##_private_v32)) \
+SAUL_PRIVATE_X86_ONLY(SAUL_PRIVATE_DEFINE_T_KERNELS(prefix, T, U, avx512, __attribute__((target("avx512f,avx512bw"))), prefix##_private_v64)) \
+ \
+typedef struct { \
+    void (*add)(T *, const T *, const T *, int); \
+    void (*sub)(T *, const T *, const T *, int); \
+    void (*axpy)(T *restrict, const T *restrict, T, int); \
+    void (*scale)(T *, int, T); \
+} prefix##_private_ops_table; \
+ \
+static const prefix##_private_ops_table prefix##_private_tables[] = { \
+    [SAUL_ISA_SCALAR] = SAUL_PRIVATE_T_TABLE(prefix, scalar), \
+    SAUL_PRIVATE_X86_ONLY([SAUL_ISA_SSE2] = SAUL_PRIVATE_T_TABLE(prefix, sse2),) \
+    SAUL_PRIVATE_X86_ONLY([SAUL_ISA_AVX2] = SAUL_PRIVATE_T_TABLE(prefix, avx2),) \
+    SAUL_PRIVATE_X86_ONLY([SAUL_ISA_AVX512] = SAUL_PRIVATE_T_TABLE(prefix, avx512),) \
+}; \
+ \
+/* The table for the ISA saul_init()/saul_set_isa() picked for float. \
+   Nothing is cached, so there is no table to tear; the 64-byte kernels \
+   also need avx512bw, which float's AVX512 level does not check */ \
+static const prefix##_private_ops_table *prefix##_private_ready(void) { \
+    saul_isa isa = saul_private_ops()->isa; \
+    SAUL_PRIVATE_X86_ONLY( \
+    if(isa == SAUL_ISA_AVX512 && !__builtin_cpu_supports("avx512bw")) { \
+        isa = SAUL_ISA_AVX2; \
+    }) \
+    return &prefix##_private_tables[isa]; \
+} \
+ \
+Type *prefix##_new_matrix(int rows, int cols) { \
+    if(rows < 0 || cols < 0) { \
+        return NULL; \
+    } \
+    Type *m = (Type *)malloc(sizeof(Type)); \
+    if(m == NULL) { \
+        return NULL; \
+    } \
+    int align = 64 / (int)sizeof(T); \
+    m->rows = rows; \
+    m->cols = cols; \
+    m->stride = (cols + align - 1) / align * align; \
+    size_t bytes = (size_t)rows * m->stride * sizeof(T); \
+    void *items = NULL; \
+    if(posix_memalign(&items, 64, bytes > 0 ? bytes : 64) != 0) { \
+        free(m); \
+        return NULL; \
+    } \
+    memset(items, 0, bytes); \
+    m->items = (T *)items; \
+    m->owns_items = 1; \
+    return m; \
+} \
+ \
+void prefix##_free_matrix(Type *m) { \
+    if(m == NULL) { \
+        return; \
+    } \
+    if(m->owns_items) { \
+        free(m->items); \
+    } \
+    free(m); \
+} \
+ \
+int prefix##_view_into(Type *view, Type *m, int r0, int c0, int rows, int cols) { \
+    if(r0 < 0 || c0 < 0 || rows < 0 || cols < 0 || r0 + rows > m->rows || c0 + cols > m->cols) { \
+        return -1; \
+    } \
+    view->rows = rows; \
+    view->cols = cols; \
+    view->stride = m->stride; \
+    view->items = m->items + (size_t)r0 * m->stride + c0; \
+    view->owns_items = 0; \
+    return 0; \
+} \
+ \
+Type *prefix##_view(Type *m, int r0, int c0, int rows, int cols) { \
+    Type *view = (Type *)malloc(sizeof(Type)); \
+    if(view == NULL) { \
+        return NULL; \
+    } \
+    if(prefix##_view_into(view, m, r0, c0, rows, cols) < 0) { \
+        free(view); \
+        return NULL; \
+    } \
+    return view; \
+} \
+ \
+int prefix##_matrix_set_value(Type *m, int i, int j, T value) { \
+    if(i < 0 || j < 0 || i >= m->rows || j >= m->cols) { \
+        return -1; \
+    } \
+    SAUL_AT(m, i, j) = value; \
+    return 0; \
+} \
+ \
+T prefix##_get_value_by_index(Type *m, int i, int j) { \
+    if(i < 0 || j < 0 || i >= m->rows || j >= m->cols) { \
+        return (T)-1; \
+    } \
+    return SAUL_AT(m, i, j); \
+} \
+ \
+void prefix##_matrix_for_each_row(Type *m, prefix##_row_call_back cb, void *ctx) { \
+    for(int i = 0; i < m->rows; i++) { \
+        cb(&SAUL_AT(m, i, 0), m->cols, ctx); \
+    } \
+} \
+ \
+static int prefix##_private_overlaps(Type *a, Type *b) { \
+    return saul_private_overlaps_bytes(a->items, a->rows, a->cols, a->stride, \
+                                       b->items, b->rows, b->cols, b->stride, sizeof(T)); \
+} \
+ \
+typedef struct { \
+    Type *dst; \
+    Type *a; \
+    Type *b; \
+    const prefix##_private_ops_table *ops; \
+    void (*ewise)(T *, const T *, const T *, int); \
+    T s; \
+    int kind; \
+    int n_tasks; \
+} prefix##_private_job; \
+ \
+/* kind 0: dst = a + b (s == 0) or a - b, 1: dst += s * a, 2: dst *= s, 3: dst = a * b */ \
+static void prefix##_private_task(void *arg, int task) { \
+    prefix##_private_job *job = (prefix##_private_job *)arg; \
+    int from = (int)((long long)job->dst->rows * task / job->n_tasks); \
+    int to = (int)((long long)job->dst->rows * (task + 1) / job->n_tasks); \
+    int n = job->dst->cols; \
+    for(int i = from; i < to; i++) { \
+        T *row = &SAUL_AT(job->dst, i, 0); \
+        if(job->kind == 0) { \
+            job->ewise(row, &SAUL_AT(job->a, i, 0), &SAUL_AT(job->b, i, 0), n); \
+        } else if(job->kind == 1) { \
+            job->ops->axpy(row, &SAUL_AT(job->a, i, 0), job->s, n); \
+        } else if(job->kind == 2) { \
+            job->ops->scale(row, n, job->s); \
+        } else { \
+            memset(row, 0, (size_t)n * sizeof(T)); \
+        } \
+    } \
+    if(job->kind != 3) { \
+        return; \
+    } \
+    /* Row of C += a_ik * row k of B, in KC x 1024 blocks so the B block \
+       stays in cache across the task's rows */ \
+    for(int k0 = 0; k0 < job->a->cols; k0 += SAUL_GEMM_KC) { \
+        int k1 = k0 + SAUL_GEMM_KC < job->a->cols ? k0 + SAUL_GEMM_KC : job->a->cols; \
+        for(int j0 = 0; j0 < n; j0 += 1024) { \
+            int w = j0 + 1024 < n ? 1024 : n - j0; \
+            for(int i = from; i < to; i++) { \
+                T *row = &SAUL_AT(job->dst, i, j0); \
+                for(int k = k0; k < k1; k++) { \
+                    job->ops->axpy(row, &SAUL_AT(job->b, k, j0), SAUL_AT(job->a, i, k), w); \
+                } \
+            } \
+        } \
+    } \
+} \
+ \
+static void prefix##_private_run(Type *dst, Type *a, Type *b, int kind, T s, size_t work) { \
+    prefix##_private_job job = { dst, a, b, prefix##_private_ready(), NULL, s, kind, 1 }; \
+    if(kind == 0) { \
+        job.ewise = s == 0 ? job.ops->add : job.ops->sub; \
+    } \
+    size_t per_row = dst->rows > 0 ? work / (size_t)dst->rows : 0; \
+    job.n_tasks = saul_private_row_tasks(dst->rows, per_row > 0 ? (int)(per_row < (size_t)1 << 30 ? per_row : (size_t)1 << 30) : 1); \
+    saul_private_parallel_for(job.n_tasks, prefix##_private_task, &job); \
+} \
+ \
+int prefix##_matrix_add_into(Type *a, Type *b, Type *out) { \
+    if(a->rows != b->rows || a->cols != b->cols || out->rows != a->rows || out->cols != a->cols) { \
+        return -1; \
+    } \
+    prefix##_private_run(out, a, b, 0, (T)0, (size_t)a->rows * a->cols); \
+    return 0; \
+} \
+ \
+int prefix##_matrix_sub_into(Type *a, Type *b, Type *out) { \
+    if(a->rows != b->rows || a->cols != b->cols || out->rows != a->rows || out->cols != a->cols) { \
+        return -1; \
+    } \
+    prefix##_private_run(out, a, b, 0, (T)1, (size_t)a->rows * a->cols); \
+    return 0; \
+} \
+ \
+int prefix##_matrix_add(Type *m1, Type *m2) { \
+    return prefix##_matrix_add_into(m1, m2, m1); \
+} \
+ \
+int prefix##_matrix_sub(Type *m1, Type *m2) { \
+    return prefix##_matrix_sub_into(m1, m2, m1); \
+} \
+ \
+void prefix##_matrix_scale(Type *m, T alpha) { \
+    prefix##_private_run(m, NULL, NULL, 2, alpha, (size_t)m->rows * m->cols); \
+} \
+ \
+int prefix##_matrix_axpy(T alpha, Type *x, Type *y) { \
+    if(x->rows != y->rows || x->cols != y->cols) { \
+        return -1; \
+    } \
+    if(x->items == y->items && x->stride == y->stride) { \
+        prefix##_matrix_scale(y, (T)((U)1 + (U)alpha)); \
+        return 0; \
+    } \
+    if(prefix##_private_overlaps(x, y)) { \
+        return -1; \
+    } \
+    prefix##_private_run(y, x, NULL, 1, alpha, (size_t)y->rows * y->cols); \
+    return 0; \
+} \
+ \
+int prefix##_matrix_mul_into(Type *a, Type *b, Type *out) { \
+    if(a->cols != b->rows || out->rows != a->rows || out->cols != b->cols || \
+       prefix##_private_overlaps(out, a) || prefix##_private_overlaps(out, b)) { \
+        return -1; \
+    } \
+    prefix##_private_run(out, a, b, 3, (T)0, (size_t)a->rows * a->cols * b->cols); \
+    return 0; \
+} \
+ \
+Type *prefix##_matrix_mul(Type *m1, Type *m2) { \
+    if(m1->cols != m2->rows) { \
+        return NULL; \
+    } \
+    Type *m3 = prefix##_new_matrix(m1->rows, m2->cols); \
+    if(m3 != NULL && prefix##_matrix_mul_into(m1, m2, m3) < 0) { \
+        prefix##_free_matrix(m3); \
+        return NULL; \
+    } \
+    return m3; \
+} \
+ \
+int prefix##_matrix_transpose_into(Type *m, Type *out) { \
+    if(out->rows != m->cols || out->cols != m->rows || prefix##_private_overlaps(m, out)) { \
+        return -1; \
+    } \
+    for(int i0 = 0; i0 < m->rows; i0 += SAUL_TRANSPOSE_BLOCK) { \
+        int i1 = i0 + SAUL_TRANSPOSE_BLOCK < m->rows ? i0 + SAUL_TRANSPOSE_BLOCK : m->rows; \
+        for(int j0 = 0; j0 < m->cols; j0 += SAUL_TRANSPOSE_BLOCK) { \
+            int j1 = j0 + SAUL_TRANSPOSE_BLOCK < m->cols ? j0 + SAUL_TRANSPOSE_BLOCK : m->cols; \
+            for(int i = i0; i < i1; i++) { \
+                for(int j = j0; j < j1; j++) { \
+                    SAUL_AT(out, j, i) = SAUL_AT(m, i, j); \
+                } \
+            } \
+        } \
+    } \
+    return 0; \
+}
+
+#define SAUL_DEFINE_SOLVERS(prefix, Type, T) \
+/* Eight partial sums, see saul_private_dot() */ \
+static T prefix##_private_dot(const T *x, const T *y, int n) { \
+    T acc[8] = { 0 }; \
+    int j = 0; \
+    for(; j + 8 <= n; j += 8) { \
+        for(int l = 0; l < 8; l++) { \
+            acc[l] += x[j + l] * y[j + l]; \
+        } \
+    } \
+    T s = ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7])); \
+    for(; j < n; j++) { \
+        s += x[j] * y[j]; \
+    } \
+    return s; \
+} \
+ \
+int prefix##_lu(Type *a, int *piv) { \
+    if(a->rows != a->cols || piv == NULL) { \
+        return -1; \
+    } \
+    const prefix##_private_ops_table *ops = prefix##_private_ready(); \
+    int n = a->rows; \
+    int singular = 0; \
+    for(int j = 0; j < n; j++) { \
+        int p = j; \
+        T best = (T)fabs((double)SAUL_AT(a, j, j)); \
+        for(int i = j + 1; i < n; i++) { \
+            T v = (T)fabs((double)SAUL_AT(a, i, j)); \
+            if(v > best) { \
+                best = v; \
+                p = i; \
+            } \
+        } \
+        piv[j] = p; \
+        if(p != j) { \
+            for(int l = 0; l < n; l++) { \
+                T t = SAUL_AT(a, j, l); \
+                SAUL_AT(a, j, l) = SAUL_AT(a, p, l); \
+                SAUL_AT(a, p, l) = t; \
+            } \
+        } \
+        if(best == 0) { \
+            singular = 1; \
+            continue; \
+        } \
+        for(int i = j + 1; i < n; i++) { \
+            T f = SAUL_AT(a, i, j) / SAUL_AT(a, j, j); \
+            SAUL_AT(a, i, j) = f; \
+            ops->axpy(&SAUL_AT(a, i, j + 1), &SAUL_AT(a, j, j + 1), -f, n - j - 1); \
+        } \
+    } \
+    return singular ? -2 : 0; \
+} \
+ \
+int prefix##_lu_solve(Type *lu, const int *piv, Type *b) { \
+    if(lu->rows != lu->cols || b->rows != lu->rows || piv == NULL) { \
+        return -1; \
+    } \
+    const prefix##_private_ops_table *ops = prefix##_private_ready(); \
+    int n = lu->rows; \
+    for(int i = 0; i < n; i++) { \
+        if(SAUL_AT(lu, i, i) == 0) { \
+            return -2; \
+        } \
+    } \
+    for(int i = 0; i < n; i++) { \
+        if(piv[i] != i) { \
+            for(int l = 0; l < b->cols; l++) { \
+                T t = SAUL_AT(b, i, l); \
+                SAUL_AT(b, i, l) = SAUL_AT(b, piv[i], l); \
+                SAUL_AT(b, piv[i], l) = t; \
+            } \
+        } \
+    } \
+    for(int i = 0; i < n; i++) { \
+        for(int j = 0; j < i; j++) { \
+            ops->axpy(&SAUL_AT(b, i, 0), &SAUL_AT(b, j, 0), -SAUL_AT(lu, i, j), b->cols); \
+        } \
+    } \
+    for(int i = n - 1; i >= 0; i--) { \
+        for(int j = i + 1; j < n; j++) { \
+            ops->axpy(&SAUL_AT(b, i, 0), &SAUL_AT(b, j, 0), -SAUL_AT(lu, i, j), b->cols); \
+        } \
+        ops->scale(&SAUL_AT(b, i, 0), b->cols, 1 / SAUL_AT(lu, i, i)); \
+    } \
+    return 0; \
+} \
+ \
+T prefix##_det(Type *m) { \
+    if(m->rows != m->cols) { \
+        return (T)NAN; \
+    } \
+    Type *lu = prefix##_new_matrix(m->rows, m->cols); \
+    int *piv = (int *)malloc((size_t)(m->rows > 0 ? m->rows : 1) * sizeof(int)); \
+    T det = (T)NAN; \
+    if(lu != NULL && piv != NULL) { \
+        for(int i = 0; i < m->rows; i++) { \
+            memcpy(&SAUL_AT(lu, i, 0), &SAUL_AT(m, i, 0), (size_t)m->cols * sizeof(T)); \
+        } \
+        det = 1; \
+        if(prefix##_lu(lu, piv) == 0) { \
+            for(int i = 0; i < m->rows; i++) { \
+                det *= piv[i] != i ? -SAUL_AT(lu, i, i) : SAUL_AT(lu, i, i); \
+            } \
+        } else { \
+            det = 0; \
+        } \
+    } \
+    prefix##_free_matrix(lu); \
+    free(piv); \
+    return det; \
+} \
+ \
+int prefix##_cholesky(Type *a) { \
+    if(a->rows != a->cols) { \
+        return -1; \
+    } \
+    for(int j = 0; j < a->rows; j++) { \
+        T *rj = &SAUL_AT(a, j, 0); \
+        T d = rj[j] - prefix##_private_dot(rj, rj, j); \
+        if(!(d > 0)) { \
+            return -2; \
+        } \
+        d = (T)sqrt((double)d); \
+        rj[j] = d; \
+        for(int i = j + 1; i < a->rows; i++) { \
+            SAUL_AT(a, i, j) = (SAUL_AT(a, i, j) - prefix##_private_dot(&SAUL_AT(a, i, 0), rj, j)) / d; \
+        } \
+    } \
+    return 0; \
+} \
+ \
+int prefix##_cholesky_solve(Type *l, Type *b) { \
+    if(l->rows != l->cols || b->rows != l->rows) { \
+        return -1; \
+    } \
+    const prefix##_private_ops_table *ops = prefix##_private_ready(); \
+    int n = l->rows; \
+    for(int i = 0; i < n; i++) { \
+        if(!(SAUL_AT(l, i, i) > 0)) { \
+            return -2; \
+        } \
+    } \
+    for(int i = 0; i < n; i++) { \
+        for(int j = 0; j < i; j++) { \
+            ops->axpy(&SAUL_AT(b, i, 0), &SAUL_AT(b, j, 0), -SAUL_AT(l, i, j), b->cols); \
+        } \
+        ops->scale(&SAUL_AT(b, i, 0), b->cols, 1 / SAUL_AT(l, i, i)); \
+    } \
+    for(int i = n - 1; i >= 0; i--) { \
+        for(int j = i + 1; j < n; j++) { \
+            ops->axpy(&SAUL_AT(b, i, 0), &SAUL_AT(b, j, 0), -SAUL_AT(l, j, i), b->cols); \
+        } \
+        ops->scale(&SAUL_AT(b, i, 0), b->cols, 1 / SAUL_AT(l, i, i)); \
+    } \
+    return 0; \
+}
+
+SAUL_DEFINE_MATRIX_TYPE(saul_f64, MatrixF64, double, double)
+SAUL_DEFINE_SOLVERS(saul_f64, MatrixF64, double)
+SAUL_DEFINE_MATRIX_TYPE(saul_i32, MatrixI32, int32_t, uint32_t)
+SAUL_DEFINE_MATRIX_TYPE(saul_i8, MatrixI8, int8_t, uint8_t)
+
+// float keeps its original names, these spell it like the other types
+typedef Matrix MatrixF32;
+#define saul_f32_new_matrix saul_new_matrix
+#define saul_f32_free_matrix saul_free_matrix
+#define saul_f32_view_into saul_view_into
+#define saul_f32_view saul_view
+#define saul_f32_matrix_set_value saul_matrix_set_value
+#define saul_f32_get_value_by_index saul_get_value_by_index
+#define saul_f32_matrix_for_each_row saul_matrix_for_each_row
+#define saul_f32_matrix_add_into saul_matrix_add_into
+#define saul_f32_matrix_sub_into saul_matrix_sub_into
+#define saul_f32_matrix_add saul_matrix_add
+#define saul_f32_matrix_sub saul_matrix_sub
+#define saul_f32_matrix_scale saul_matrix_scale
+#define saul_f32_matrix_axpy saul_matrix_axpy
+#define saul_f32_matrix_mul_into saul_matrix_mul_into
+#define saul_f32_matrix_mul saul_matrix_mul
+#define saul_f32_matrix_transpose_into saul_matrix_transpose_into
+#define saul_f32_lu saul_lu
+#define saul_f32_lu_solve saul_lu_solve
+#define saul_f32_det saul_det
+#define saul_f32_cholesky saul_cholesky
+#define saul_f32_cholesky_solve saul_cholesky_solve
 
 #endif // SAUL_IMPLEMENTATION
 #endif // INCLUDE_SAUL_H
\ No newline at end of file
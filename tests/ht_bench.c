@@ -0,0 +1,519 @@
+// gcc -O2 -I ht -I ticky tests/ht_bench.c -o ht_bench -lpthread
+// ./ht_bench [filter]   runs only the benchmarks whose name contains filter
+#define TICKY_IMPLEMENTATION
+#define HT_IMPLEMENTATION
+#include <ht.h>
+#include <ticky.h>
+
+#include <stdlib.h>
+#include <math.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+
+// Item counts from L1-resident up to larger than a typical LLC
+#ifndef HT_BENCH_SIZES
+#define HT_BENCH_SIZES { 1 << 10, 1 << 15, 1 << 20, 1 << 23 }
+#endif
+
+#define BATCH 4096
+#define SEQ_LEN (1 << 16)
+#define KEY_LEN 16
+#define GROW_ITEMS (1 << 16)
+
+typedef struct {
+    char *keys;
+    size_t stride;
+    size_t n;
+} keyset;
+
+static const char *filter;
+static ticky_stats *stats;
+
+static Map *map;
+static keyset hits;
+static keyset misses;
+static uint32_t *seq;
+static uint32_t *uniform_seq;
+static uint32_t *zipf_seq;
+static uint32_t pos;
+static int miss_percent;
+static volatile uintptr_t sink;
+
+static uint64_t rng = 88172645463325252ULL;
+
+static uint64_t next_random() {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+static const char *key_at(keyset *k, size_t i) {
+    return k->keys + i * k->stride;
+}
+
+// Keys are a tag, the index in hex, then padding up to len bytes
+static keyset make_keys(size_t n, size_t len, char tag) {
+    keyset k;
+    k.n = n;
+    k.stride = len + 1;
+    k.keys = (char *)malloc(n * k.stride);
+    for(size_t i = 0; i < n; i++) {
+        char *dst = k.keys + i * k.stride;
+        int w = snprintf(dst, k.stride, "%c%zx", tag, i);
+        memset(dst + w, 'x', len - w);
+        dst[len] = '\0';
+    }
+    return k;
+}
+
+static void fill_uniform(uint32_t *out, size_t n) {
+    for(size_t i = 0; i < SEQ_LEN; i++) {
+        out[i] = (uint32_t)(next_random() % n);
+    }
+}
+
+// Zipf(0.99) over n ranks, ranks are scattered so hot keys don't share cache lines
+static void fill_zipf(uint32_t *out, size_t n) {
+    double *cdf = (double *)malloc(n * sizeof(double));
+    double sum = 0;
+    for(size_t i = 0; i < n; i++) {
+        sum += 1.0 / pow((double)(i + 1), 0.99);
+        cdf[i] = sum;
+    }
+
+    for(size_t i = 0; i < SEQ_LEN; i++) {
+        double u = (double)(next_random() >> 11) / (double)(1ULL << 53) * sum;
+        size_t lo = 0, hi = n - 1;
+        while(lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if(cdf[mid] < u) lo = mid + 1; else hi = mid;
+        }
+        out[i] = (uint32_t)((lo * 2654435761ULL) % n);
+    }
+    free(cdf);
+}
+
+static Map *build_map(keyset *k, size_t capacity) {
+    Map *m = ht_new_map(capacity);
+    for(size_t i = 0; i < k->n; i++) {
+        ht_set(m, key_at(k, i), (void *)(i + 1));
+    }
+    return m;
+}
+
+void bench_get() {
+    for(int i = 0; i < BATCH; i++) {
+        uint32_t idx = seq[pos++ & (SEQ_LEN - 1)];
+        sink += (uintptr_t)ht_get(map, key_at(&hits, idx));
+    }
+}
+
+void bench_get_mixed() {
+    for(int i = 0; i < BATCH; i++) {
+        uint32_t idx = seq[pos++ & (SEQ_LEN - 1)];
+        keyset *k = (int)(idx % 100) < miss_percent ? &misses : &hits;
+        sink += (uintptr_t)ht_get(map, key_at(k, idx % k->n));
+    }
+}
+
+void bench_set_existing() {
+    for(int i = 0; i < BATCH; i++) {
+        uint32_t idx = seq[pos++ & (SEQ_LEN - 1)];
+        ht_set(map, key_at(&hits, idx), (void *)(uintptr_t)(i + 1));
+    }
+}
+
+void bench_grow() {
+    Map *m = ht_new_map(8);
+    for(size_t i = 0; i < GROW_ITEMS; i++) {
+        ht_set(m, key_at(&hits, i), (void *)(i + 1));
+    }
+    sink += ht_length(m);
+    ht_free(m);
+}
+
+static void bench(const char *name, func fn, int n_ops) {
+    if(filter != NULL && strstr(name, filter) == NULL) {
+        return;
+    }
+    ticky_bench(stats, (char *)name, fn, NULL);
+    printf("%s...%.1f ns/op\n", name, stats->results[stats->n_results - 1]->avg * 1e9 / n_ops);
+}
+
+static void bench_bytes(const char *name, func fn, size_t bytes) {
+    if(filter != NULL && strstr(name, filter) == NULL) {
+        return;
+    }
+    ticky_bench(stats, (char *)name, fn, NULL);
+    printf("%s...%.2f GB/s\n", name, bytes / stats->results[stats->n_results - 1]->avg / 1e9);
+}
+
+static char *label(const char *fmt, size_t a, size_t b) {
+    char *s = (char *)malloc(96);
+    snprintf(s, 96, fmt, a, b);
+    return s;
+}
+
+static void print_footprint(Map *m, keyset *k) {
+    double table = (double)(m->capacity * sizeof(ht_entry)) / m->items;
+    printf("  footprint: %.1f B/entry table + %zu B/entry key (capacity %zu, load %.0f%%)\n",
+           table, k->stride, m->capacity, 100.0 * m->items / m->capacity);
+}
+
+// Access pattern and hit/miss ratio across working-set sizes
+static void size_sweep() {
+    size_t sizes[] = HT_BENCH_SIZES;
+
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t n = sizes[s];
+        hits = make_keys(n, KEY_LEN, 'k');
+        misses = make_keys(n, KEY_LEN, 'm');
+        map = build_map(&hits, 16);
+        fill_uniform(uniform_seq, n);
+        fill_zipf(zipf_seq, n);
+
+        printf("\n[%zu items]\n", n);
+        print_footprint(map, &hits);
+
+        seq = uniform_seq;
+        bench(label("get uniform hit n=%zu", n, 0), bench_get, BATCH);
+        seq = zipf_seq;
+        bench(label("get zipf hit n=%zu", n, 0), bench_get, BATCH);
+
+        seq = uniform_seq;
+        miss_percent = 50;
+        bench(label("get 50%% miss n=%zu", n, 0), bench_get_mixed, BATCH);
+        miss_percent = 100;
+        bench(label("get 100%% miss n=%zu", n, 0), bench_get_mixed, BATCH);
+
+        bench(label("set existing n=%zu", n, 0), bench_set_existing, BATCH);
+
+        ht_free(map);
+        free(hits.keys);
+        free(misses.keys);
+    }
+}
+
+static void key_length_sweep() {
+    size_t lens[] = { 8, 32, 128 };
+    size_t n = 1 << 16;
+
+    printf("\n[key lengths, %zu items]\n", n);
+    for(size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+        hits = make_keys(n, lens[l], 'k');
+        map = build_map(&hits, 16);
+        fill_uniform(uniform_seq, n);
+        seq = uniform_seq;
+
+        bench(label("get key len=%zu n=%zu", lens[l], n), bench_get, BATCH);
+
+        ht_free(map);
+        free(hits.keys);
+    }
+}
+
+// Map keeps load at or below 50%, pre-sizing picks a lower one
+static void load_factor_sweep() {
+    size_t n = 1 << 16;
+    size_t factors[] = { 16, 8, 2 };
+
+    hits = make_keys(n, KEY_LEN, 'k');
+    misses = make_keys(n, KEY_LEN, 'm');
+    fill_uniform(uniform_seq, n);
+    seq = uniform_seq;
+    miss_percent = 100;
+
+    printf("\n[load factors, %zu items]\n", n);
+    for(size_t f = 0; f < sizeof(factors) / sizeof(factors[0]); f++) {
+        map = build_map(&hits, n * factors[f] + 1);
+        size_t load = 100 * map->items / map->capacity;
+
+        bench(label("get hit load=%zu%% n=%zu", load, n), bench_get, BATCH);
+        bench(label("get miss load=%zu%% n=%zu", load, n), bench_get_mixed, BATCH);
+
+        ht_free(map);
+    }
+    free(hits.keys);
+    free(misses.keys);
+}
+
+static CompactMap *compact;
+
+void bench_compact_get() {
+    for(int i = 0; i < BATCH; i++) {
+        uint32_t idx = seq[pos++ & (SEQ_LEN - 1)];
+        keyset *k = (int)(idx % 100) < miss_percent ? &misses : &hits;
+        sink += (uintptr_t)ht_compact_get(compact, key_at(k, idx % k->n));
+    }
+}
+
+static void compact_bench() {
+    size_t n = 1 << 20;
+    hits = make_keys(n, KEY_LEN, 'k');
+    misses = make_keys(n, KEY_LEN, 'm');
+    fill_uniform(uniform_seq, n);
+    seq = uniform_seq;
+
+    map = build_map(&hits, 16);
+    compact = ht_compact_new(16);
+    for(size_t i = 0; i < n; i++) {
+        ht_compact_set(compact, key_at(&hits, i), (void *)(i + 1));
+    }
+
+    printf("\n[compact vs Map, %zu items]\n", n);
+    printf("  footprint: Map %.1f B/entry table + %zu B/entry key | compact %.1f B/entry table + %.1f B/entry arena\n",
+           (double)(map->capacity * sizeof(ht_entry)) / n, hits.stride,
+           (double)(compact->capacity * sizeof(ht_compact_slot)) / n, (double)compact->arena_len / n);
+
+    miss_percent = 0;
+    bench(label("get hit Map n=%zu", n, 0), bench_get_mixed, BATCH);
+    bench(label("get hit compact n=%zu", n, 0), bench_compact_get, BATCH);
+    miss_percent = 100;
+    bench(label("get miss Map n=%zu", n, 0), bench_get_mixed, BATCH);
+    bench(label("get miss compact n=%zu", n, 0), bench_compact_get, BATCH);
+
+    ht_compact_destroy(compact);
+    ht_free(map);
+    free(hits.keys);
+    free(misses.keys);
+}
+
+static InlineMap *inline_map;
+
+void bench_inline_get() {
+    for(int i = 0; i < BATCH; i++) {
+        uint32_t idx = seq[pos++ & (SEQ_LEN - 1)];
+        keyset *k = (int)(idx % 100) < miss_percent ? &misses : &hits;
+        sink += (uintptr_t)ht_inline_get(inline_map, key_at(k, idx % k->n));
+    }
+}
+
+// Short keys stored in the slot vs Map's pointer to a key elsewhere. With
+// the probe buffer as Map's keys, strcmp() reads the line the hash just
+// loaded; with one heap copy per key, allocated in random order as a
+// long-lived map ends up, every compare is a miss of its own
+static void inline_bench() {
+    size_t n = 1 << 20;
+    hits = make_keys(n, 12, 'k');
+    misses = make_keys(n, 12, 'm');
+    fill_uniform(uniform_seq, n);
+    seq = uniform_seq;
+
+    size_t *order = (size_t *)malloc(n * sizeof(size_t));
+    char **copies = (char **)malloc(n * sizeof(char *));
+    for(size_t i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    for(size_t i = n - 1; i > 0; i--) {
+        size_t j = next_random() % (i + 1);
+        size_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    for(size_t i = 0; i < n; i++) {
+        copies[order[i]] = strdup(key_at(&hits, order[i]));
+    }
+
+    Map *shared = build_map(&hits, 16);
+    Map *heap = ht_new_map(16);
+    inline_map = ht_inline_new(16);
+    for(size_t i = 0; i < n; i++) {
+        ht_set(heap, copies[i], (void *)(i + 1));
+        ht_inline_set(inline_map, key_at(&hits, i), (void *)(i + 1));
+    }
+
+    printf("\n[inline keys vs Map, %zu items, 12 byte keys]\n", n);
+    miss_percent = 0;
+    map = shared;
+    bench(label("get hit Map shared keys n=%zu", n, 0), bench_get_mixed, BATCH);
+    map = heap;
+    bench(label("get hit Map heap keys n=%zu", n, 0), bench_get_mixed, BATCH);
+    bench(label("get hit inline n=%zu", n, 0), bench_inline_get, BATCH);
+    miss_percent = 100;
+    map = shared;
+    bench(label("get miss Map shared keys n=%zu", n, 0), bench_get_mixed, BATCH);
+    map = heap;
+    bench(label("get miss Map heap keys n=%zu", n, 0), bench_get_mixed, BATCH);
+    bench(label("get miss inline n=%zu", n, 0), bench_inline_get, BATCH);
+
+    ht_inline_destroy(inline_map);
+    ht_free(shared);
+    ht_free(heap);
+    for(size_t i = 0; i < n; i++) {
+        free(copies[i]);
+    }
+    free(copies);
+    free(order);
+    free(hits.keys);
+    free(misses.keys);
+}
+
+#define HASH_KEYS 4096
+
+static const char *hash_keys[HASH_KEYS];
+static size_t hash_lens[HASH_KEYS];
+static uint64_t hash_out[HASH_KEYS];
+
+void bench_hash_one() {
+    for(int i = 0; i < HASH_KEYS; i++) {
+        hash_out[i] = ht__hash_n(hash_keys[i], hash_lens[i]);
+    }
+}
+
+void bench_hash_batch() {
+    ht_hash_batch(hash_keys, hash_lens, HASH_KEYS, hash_out);
+}
+
+void bench_get_batch() {
+    const char *keys[256];
+    void *values[256];
+    for(int i = 0; i < BATCH; i += 256) {
+        for(int k = 0; k < 256; k++) {
+            keys[k] = key_at(&hits, seq[pos++ & (SEQ_LEN - 1)]);
+        }
+        sink += ht_get_batch(map, keys, 256, values);
+    }
+}
+
+// Hashing throughput over L1-resident keys, then batched vs one-by-one gets
+static void hash_bench() {
+    size_t lens[] = { 8, 16, 64 };
+
+    printf("\n[batched hashing, %d keys, %d lanes]\n", HASH_KEYS, HT_HASH_LANES);
+    for(size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+        hits = make_keys(HASH_KEYS, lens[l], 'k');
+        for(int i = 0; i < HASH_KEYS; i++) {
+            hash_keys[i] = key_at(&hits, i);
+            hash_lens[i] = lens[l];
+        }
+
+        bench_bytes(label("hash one-by-one key len=%zu", lens[l], 0), bench_hash_one, HASH_KEYS * lens[l]);
+        bench_bytes(label("hash batch key len=%zu", lens[l], 0), bench_hash_batch, HASH_KEYS * lens[l]);
+        free(hits.keys);
+    }
+
+    size_t n = 1 << 20;
+    hits = make_keys(n, KEY_LEN, 'k');
+    fill_uniform(uniform_seq, n);
+    seq = uniform_seq;
+    map = build_map(&hits, 16);
+
+    bench(label("get one-by-one n=%zu", n, 0), bench_get, BATCH);
+    bench(label("get batch n=%zu", n, 0), bench_get_batch, BATCH);
+
+    ht_free(map);
+    free(hits.keys);
+}
+
+static void grow_bench() {
+    hits = make_keys(GROW_ITEMS, KEY_LEN, 'k');
+    printf("\n[growth]\n");
+    bench(label("set from capacity 8 to n=%zu", GROW_ITEMS, 0), bench_grow, GROW_ITEMS);
+    free(hits.keys);
+}
+
+// dTLB read misses over a fixed number of random lookups, -1 if perf is not available
+static long long count_tlb_misses(Map *m) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+
+    int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if(fd < 0) {
+        return -1;
+    }
+
+    Map *saved = map;
+    map = m;
+    long long count = 0;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    for(int i = 0; i < 256; i++) {
+        bench_get();
+    }
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if(read(fd, &count, sizeof(count)) != sizeof(count)) {
+        count = -1;
+    }
+    close(fd);
+    map = saved;
+    return count;
+}
+
+static Map *small_pages;
+static Map *huge_pages;
+
+void get_small_pages() {
+    map = small_pages;
+    bench_get();
+}
+
+void get_huge_pages() {
+    map = huge_pages;
+    bench_get();
+}
+
+static Map *build_placed_map(keyset *k, int flags) {
+    ht_mem_opts opts = { flags, 0 };
+    Map *m = ht_new_map_opts(k->n * 4, &opts);
+    for(size_t i = 0; i < k->n; i++) {
+        ht_set(m, key_at(k, i), (void *)(i + 1));
+    }
+    return m;
+}
+
+static void huge_page_bench() {
+    size_t n = 1 << 22;
+    if(filter != NULL && strstr("get 4K pages", filter) == NULL && strstr("get huge pages", filter) == NULL) {
+        return;
+    }
+
+    hits = make_keys(n, KEY_LEN, 'k');
+    fill_uniform(uniform_seq, n);
+    seq = uniform_seq;
+    small_pages = build_placed_map(&hits, HT_MEM_NOHUGEPAGE);
+    huge_pages = build_placed_map(&hits, HT_MEM_HUGEPAGE);
+
+    printf("\n[page size, %zu items]\n", n);
+    bench("get 4K pages", get_small_pages, BATCH);
+    bench("get huge pages", get_huge_pages, BATCH);
+
+    long long small_misses = count_tlb_misses(small_pages);
+    long long huge_misses = count_tlb_misses(huge_pages);
+    if(small_misses >= 0 && huge_misses >= 0) {
+        printf("  dTLB misses per 1M ht_get: 4K pages %lld | huge pages %lld\n", small_misses, huge_misses);
+    } else {
+        printf("  dTLB misses: perf_event_open not available\n");
+    }
+
+    ht_free(small_pages);
+    ht_free(huge_pages);
+    free(hits.keys);
+}
+
+int main(int argc, char **argv) {
+    filter = argc > 1 ? argv[1] : NULL;
+    stats = ticky_new_stats();
+    uniform_seq = (uint32_t *)malloc(SEQ_LEN * sizeof(uint32_t));
+    zipf_seq = (uint32_t *)malloc(SEQ_LEN * sizeof(uint32_t));
+
+    size_sweep();
+    key_length_sweep();
+    load_factor_sweep();
+    grow_bench();
+    compact_bench();
+    inline_bench();
+    hash_bench();
+    huge_page_bench();
+
+    printf("\n");
+    ticky_plot(stats);
+
+    free(uniform_seq);
+    free(zipf_seq);
+}
@@ -2,6 +2,7 @@
 #define HT_IMPLEMENTATION
 #include <ht.h>
 #include <picky.h>
+#include <stdlib.h>
 
 void map_creation(T *t) {
 
@@ -61,9 +62,691 @@ void map_expand(T *t) {
     picky_int_toBe(t, m->capacity, capacity * 2);
 }
 
+void map_rehash(T *t) {
+    Map *m = ht_new_map(2);
+    char *keys[64];
+
+    for(int i = 0; i < 64; i++) {
+        keys[i] = (char *)malloc(16);
+        snprintf(keys[i], 16, "key-%d", i);
+        ht_set(m, keys[i], (void *)(intptr_t)(i + 1));
+    }
+
+    picky_test(t, "ht_set() keeps every item across expands");
+    picky_int_toBe(t, 64, (int)ht_length(m));
+
+    picky_test(t, "ht_get() finds items inserted before an expand");
+    int found = 0;
+    for(int i = 0; i < 64; i++) {
+        if(ht_get(m, keys[i]) == (void *)(intptr_t)(i + 1)) found++;
+    }
+    picky_int_toBe(t, 64, found);
+
+    ht_free(m);
+    for(int i = 0; i < 64; i++) free(keys[i]);
+}
+
+void map_intern(T *t) {
+    Interner *in = ht_intern_new(4);
+
+    picky_test(t, "ht_intern_new() not null");
+    picky_assertNotNull(t, in);
+
+    picky_test(t, "ht_intern() hands out dense ids");
+    uint32_t a = ht_intern(in, "cpu.load");
+    uint32_t b = ht_intern(in, "mem.used");
+    picky_assert(t, a == 0 && b == 1);
+
+    picky_test(t, "ht_intern() returns the same id for equal strings");
+    char buf[16];
+    strcpy(buf, "cpu.load");
+    picky_assert(t, ht_intern(in, buf) == a);
+
+    picky_test(t, "ht_intern_lookup() returns the interned string");
+    picky_assert(t, strcmp(ht_intern_lookup(in, b), "mem.used") == 0);
+
+    picky_test(t, "ht_intern_find() does not insert");
+    picky_assert(t, ht_intern_find(in, "disk.io") == HT_INTERN_NONE && ht_intern_count(in) == 2);
+
+    picky_test(t, "ht_intern() ids stay stable while the arena grows");
+    for(int i = 0; i < 1000; i++) {
+        snprintf(buf, sizeof(buf), "metric.%d", i);
+        ht_intern(in, buf);
+    }
+    picky_assert(t, ht_intern(in, "cpu.load") == a && strcmp(ht_intern_lookup(in, 501), "metric.499") == 0);
+
+    ht_intern_destroy(in);
+}
+
+void map_snapshot(T *t) {
+    Map *m = ht_new_map(2048);
+    char *keys[1500];
+
+    for(int i = 0; i < 1500; i++) {
+        keys[i] = (char *)malloc(16);
+        snprintf(keys[i], 16, "k%d", i);
+    }
+    for(int i = 0; i < 600; i++) {
+        ht_set(m, keys[i], (void *)(intptr_t)(i + 1));
+    }
+
+    MapSnapshot *snap = ht_snapshot(m);
+    picky_test(t, "ht_snapshot() not null");
+    picky_assertNotNull(t, snap);
+
+    picky_test(t, "ht_snapshot() only one alive per map");
+    picky_assert(t, ht_snapshot(m) == NULL);
+
+    ht_set(m, keys[0], (void *)(intptr_t)-1);
+    ht_set(m, keys[700], (void *)(intptr_t)701);
+
+    picky_test(t, "ht_snapshot_get() sees the value from before the write");
+    picky_assert(t, ht_snapshot_get(snap, keys[0]) == (void *)(intptr_t)1);
+
+    picky_test(t, "ht_snapshot_get() does not see later inserts");
+    picky_assert(t, ht_snapshot_get(snap, keys[700]) == NULL && ht_get(m, keys[700]) != NULL);
+
+    picky_test(t, "ht_snapshot_get() still sees a key deleted after it was taken");
+    ht_delete(m, keys[1]);
+    picky_assert(t, ht_snapshot_get(snap, keys[1]) == (void *)(intptr_t)2 && ht_get(m, keys[1]) == NULL);
+    ht_set(m, keys[1], (void *)(intptr_t)2);
+
+    // Crosses the 50% load factor, the snapshot adopts the old array
+    for(int i = 600; i < 1500; i++) {
+        ht_set(m, keys[i], (void *)(intptr_t)(i + 1));
+    }
+
+    picky_test(t, "ht_snapshot_next() iterates the items from before the expand");
+    size_t it = 0, n = 0, ok = 0;
+    const char *k;
+    void *v;
+    while(ht_snapshot_next(snap, &it, &k, &v)) {
+        n++;
+        if(ht_get(m, k) != NULL) ok++;
+    }
+    picky_assert(t, n == 600 && ok == 600 && ht_snapshot_length(snap) == 600);
+
+    ht_snapshot_release(snap);
+
+    picky_test(t, "ht_snapshot() works again after release");
+    snap = ht_snapshot(m);
+    picky_assert(t, snap != NULL && ht_snapshot_get(snap, keys[1499]) == (void *)(intptr_t)1500);
+
+    ht_free(m);
+    ht_snapshot_release(snap);
+    for(int i = 0; i < 1500; i++) free(keys[i]);
+}
+
+void map_parallel(T *t) {
+    size_t n = 20000;
+    const char **keys = (const char **)malloc(n * sizeof(char *));
+    void **values = (void **)malloc(n * sizeof(void *));
+
+    for(size_t i = 0; i < n; i++) {
+        char *k = (char *)malloc(16);
+        // Every key shows up twice, the second value must win
+        snprintf(k, 16, "key-%zu", i % (n / 2));
+        keys[i] = k;
+        values[i] = (void *)(intptr_t)(i + 1);
+    }
+
+    Map *m = ht_build_parallel(keys, values, n, 4);
+    picky_test(t, "ht_build_parallel() not null");
+    picky_assertNotNull(t, m);
+
+    picky_test(t, "ht_build_parallel() deduplicates keys");
+    picky_int_toBe(t, (int)(n / 2), (int)ht_length(m));
+
+    picky_test(t, "ht_build_parallel() keeps the last value of a key");
+    size_t ok = 0;
+    for(size_t i = n / 2; i < n; i++) {
+        if(ht_get(m, keys[i]) == values[i]) ok++;
+    }
+    picky_int_toBe(t, (int)(n / 2), (int)ok);
+
+    Map *other = ht_new_map(8);
+    ht_set(other, "key-1", (void *)(intptr_t)-1);
+    ht_set(other, "extra", (void *)(intptr_t)-2);
+
+    picky_test(t, "ht_merge() succeeds");
+    picky_int_toBe(t, 0, ht_merge(m, other));
+
+    picky_test(t, "ht_merge() adds new keys and overwrites existing ones");
+    picky_assert(t, ht_length(m) == n / 2 + 1 && ht_get(m, "key-1") == (void *)(intptr_t)-1
+                 && ht_get(m, "extra") == (void *)(intptr_t)-2 && ht_get(m, "key-2") != NULL);
+
+    // Big enough for the threaded insert into the already populated map,
+    // with keys 5000..9999 overwriting ones m already has
+    size_t big = HT_MERGE_PARALLEL_MIN + 4000;
+    char **big_keys = (char **)malloc(big * sizeof(char *));
+    Map *bulk = ht_new_map(big);
+    for(size_t i = 0; i < big; i++) {
+        big_keys[i] = (char *)malloc(16);
+        snprintf(big_keys[i], 16, "key-%zu", i + n / 4);
+        ht_set(bulk, big_keys[i], (void *)(intptr_t)-(intptr_t)(i + 1));
+    }
+
+    picky_test(t, "ht_merge() of a large map succeeds");
+    picky_int_toBe(t, 0, ht_merge(m, bulk));
+
+    picky_test(t, "ht_merge() of a large map adds and overwrites in parallel");
+    ok = 0;
+    for(size_t i = 0; i < big; i++) {
+        if(ht_get(m, big_keys[i]) == (void *)(intptr_t)-(intptr_t)(i + 1)) ok++;
+    }
+    picky_assert(t, ok == big && ht_length(m) == n / 4 + big + 1 && ht_get(m, "key-0") == values[n / 2]);
+
+    ht_free(bulk);
+    ht_free(other);
+    ht_free(m);
+    for(size_t i = 0; i < big; i++) free(big_keys[i]);
+    free(big_keys);
+    for(size_t i = 0; i < n; i++) free((void *)keys[i]);
+    free(keys);
+    free(values);
+}
+
+void map_mem_opts(T *t) {
+    ht_mem_opts opts = { HT_MEM_HUGEPAGE | HT_MEM_INTERLEAVE, 0x1 };
+    Map *m = ht_new_map_opts(4, &opts);
+
+    picky_test(t, "ht_new_map_opts() not null");
+    picky_assert(t, m != NULL && m->ht != NULL);
+
+    ht_set(m, "a", (void *)1);
+    ht_set(m, "b", (void *)2);
+    ht_set(m, "c", (void *)3);
+
+    picky_test(t, "ht_new_map_opts() map works across expands");
+    picky_assert(t, m->capacity == 8 && ht_get(m, "a") == (void *)1 && ht_get(m, "c") == (void *)3);
+
+    ht_free(m);
+
+    // 2^50 entries is past any address space, so the mmap fails
+    picky_test(t, "ht_new_map_opts() returns NULL when the table cannot be mapped");
+    picky_assert(t, ht_new_map_opts((size_t)1 << 50, &opts) == NULL);
+}
+
+void map_tsv(T *t) {
+    char path[] = "/tmp/ht_test_XXXXXX";
+    int fd = mkstemp(path);
+    const char *text = "alice\t25\nbob\t31\r\n\tskipped\nnovalue\nalice\t26\ncarol\t40";
+    write(fd, text, strlen(text));
+    close(fd);
+
+    TsvMap *m = ht_load_tsv(path);
+    picky_test(t, "ht_load_tsv() not null");
+    picky_assertNotNull(t, m);
+
+    picky_test(t, "ht_load_tsv() counts distinct keys");
+    picky_int_toBe(t, 4, (int)ht_tsv_length(m));
+
+    size_t len = 0;
+    picky_test(t, "ht_tsv_get() returns a view into the file");
+    const char *v = ht_tsv_get(m, "bob", &len);
+    picky_assert(t, v != NULL && len == 2 && memcmp(v, "31", 2) == 0);
+
+    picky_test(t, "ht_tsv_get() later duplicates win");
+    v = ht_tsv_get(m, "alice", &len);
+    picky_assert(t, v != NULL && len == 2 && memcmp(v, "26", 2) == 0);
+
+    picky_test(t, "ht_tsv_get() last line without newline and empty values");
+    picky_assert(t, ht_tsv_get(m, "carol", &len) != NULL && len == 2
+                 && ht_tsv_get(m, "novalue", &len) != NULL && len == 0);
+
+    picky_test(t, "ht_tsv_get() returns NULL to non existent key");
+    picky_assert(t, ht_tsv_get(m, "dave", &len) == NULL);
+
+    ht_tsv_destroy(m);
+    unlink(path);
+
+    picky_test(t, "ht_load_tsv() returns NULL for a missing file");
+    picky_assert(t, ht_load_tsv("/nonexistent/file.tsv") == NULL);
+}
+
+#define ATOMIC_THREADS 4
+#define ATOMIC_KEYS 20000
+
+static char atomic_keys[ATOMIC_KEYS][16];
+
+static void *atomic_inserter(void *arg) {
+    AtomicMap *m = (AtomicMap *)arg;
+    // Every thread inserts every key, only one insert per key may win
+    for(int i = 0; i < ATOMIC_KEYS; i++) {
+        ht_atomic_insert(m, atomic_keys[i], atomic_keys[i]);
+    }
+    return NULL;
+}
+
+void map_atomic(T *t) {
+    AtomicMap *m = ht_atomic_new(64);
+    for(int i = 0; i < ATOMIC_KEYS; i++) {
+        snprintf(atomic_keys[i], 16, "sym-%d", i);
+    }
+
+    picky_test(t, "ht_atomic_insert() returns the stored value");
+    int v = 7;
+    picky_assert(t, ht_atomic_insert(m, "first", &v) == &v);
+
+    picky_test(t, "ht_atomic_insert() keeps the first value of a key");
+    int w = 8;
+    picky_assert(t, ht_atomic_insert(m, "first", &w) == &v);
+
+    pthread_t threads[ATOMIC_THREADS];
+    for(int i = 0; i < ATOMIC_THREADS; i++) {
+        pthread_create(&threads[i], NULL, atomic_inserter, m);
+    }
+    for(int i = 0; i < ATOMIC_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    picky_test(t, "ht_atomic_insert() concurrent inserts never duplicate keys");
+    picky_int_toBe(t, ATOMIC_KEYS + 1, (int)ht_atomic_length(m));
+
+    picky_test(t, "ht_atomic_get() finds keys across chained tables");
+    int found = 0;
+    for(int i = 0; i < ATOMIC_KEYS; i++) {
+        if(ht_atomic_get(m, atomic_keys[i]) == atomic_keys[i]) found++;
+    }
+    picky_int_toBe(t, ATOMIC_KEYS, found);
+
+    picky_test(t, "ht_atomic_get() returns NULL to non existent key");
+    picky_assert(t, ht_atomic_get(m, "missing") == NULL);
+
+    ht_atomic_destroy(m);
+}
+
+void map_disk(T *t) {
+    char path[] = "/tmp/ht_disk_XXXXXX";
+    close(mkstemp(path));
+    unlink(path);
+
+    // A tiny pool forces evictions and reads back from the file
+    DiskMap *d = ht_disk_open(path, 4);
+    picky_test(t, "ht_disk_open() not null");
+    picky_assertNotNull(t, d);
+
+    char key[32];
+    int failed = 0;
+    for(int i = 0; i < 5000; i++) {
+        snprintf(key, sizeof(key), "disk-key-%d", i);
+        if(ht_disk_set(d, key, &i, sizeof(i)) < 0) failed++;
+    }
+
+    picky_test(t, "ht_disk_set() splits buckets as the map grows");
+    picky_assert(t, failed == 0 && ht_disk_length(d) == 5000 && d->global_depth > 0);
+
+    int v = -1;
+    ht_disk_set(d, "disk-key-7", &v, sizeof(v));
+    ht_disk_delete(d, "disk-key-8");
+
+    picky_test(t, "ht_disk_close() syncs");
+    picky_int_toBe(t, 0, ht_disk_close(d));
+
+    d = ht_disk_open(path, 8);
+    picky_test(t, "ht_disk_open() reopens an existing file");
+    picky_assert(t, d != NULL && ht_disk_length(d) == 4999);
+
+    picky_test(t, "ht_disk_get() reads values back from disk");
+    int ok = 0;
+    size_t len = 0;
+    for(int i = 0; i < 5000; i++) {
+        snprintf(key, sizeof(key), "disk-key-%d", i);
+        const void *p = ht_disk_get(d, key, &len);
+        if(i == 7 || i == 8) continue;
+        if(p && len == sizeof(int) && memcpy(&v, p, sizeof(v)) && v == i) ok++;
+    }
+    picky_int_toBe(t, 4998, ok);
+
+    picky_test(t, "ht_disk_get() sees replaced and deleted keys");
+    const void *p = ht_disk_get(d, "disk-key-7", &len);
+    picky_assert(t, p && memcpy(&v, p, sizeof(v)) && v == -1 && ht_disk_get(d, "disk-key-8", &len) == NULL);
+
+    ht_disk_close(d);
+    unlink(path);
+}
+
+void map_delete(T *t) {
+    Map *m = ht_new_map(8);
+    char keys[40][8];
+    for(int i = 0; i < 40; i++) {
+        snprintf(keys[i], 8, "d%d", i);
+        ht_set(m, keys[i], (void *)(intptr_t)(i + 1));
+    }
+
+    picky_test(t, "ht_delete() returns the removed value");
+    picky_assert(t, ht_delete(m, "d3") == (void *)4 && ht_get(m, "d3") == NULL);
+
+    picky_test(t, "ht_delete() returns NULL to non existent key");
+    picky_assert(t, ht_delete(m, "nope") == NULL);
+
+    for(int i = 0; i < 40; i += 2) {
+        ht_delete(m, keys[i]);
+    }
+
+    picky_test(t, "ht_delete() keeps the other keys reachable");
+    int ok = 0;
+    for(int i = 1; i < 40; i += 2) {
+        if(i != 3 && ht_get(m, keys[i]) == (void *)(intptr_t)(i + 1)) ok++;
+    }
+    picky_assert(t, ok == 19 && ht_length(m) == 19);
+
+    ht_free(m);
+}
+
+void map_durable(T *t) {
+    char dir[] = "/tmp/ht_wal_XXXXXX";
+    mkdtemp(dir);
+
+    DurableMap *d = ht_durable_open(dir);
+    picky_test(t, "ht_durable_open() not null");
+    picky_assertNotNull(t, d);
+
+    char key[32];
+    for(int i = 0; i < 100; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        ht_durable_set(d, key, &i, sizeof(i));
+    }
+    picky_test(t, "ht_durable_checkpoint() succeeds");
+    picky_int_toBe(t, 0, ht_durable_checkpoint(d));
+
+    // Log tail on top of the snapshot
+    int v = 1000;
+    ht_durable_set(d, "k5", &v, sizeof(v));
+    ht_durable_delete(d, "k6");
+    ht_durable_set(d, "tail", "x", 1);
+
+    picky_test(t, "ht_durable_commit() succeeds");
+    picky_int_toBe(t, 0, ht_durable_commit(d));
+    ht_durable_close(d);
+
+    // A torn record at the end of the log must be ignored
+    char wal[64];
+    snprintf(wal, sizeof(wal), "%s/wal", dir);
+    int fd = open(wal, O_WRONLY | O_APPEND);
+    write(fd, "\x01\x02\x03", 3);
+    close(fd);
+
+    d = ht_durable_open(dir);
+    picky_test(t, "ht_durable_open() recovers snapshot plus log tail");
+    picky_assert(t, d != NULL && ht_durable_length(d) == 100);
+
+    size_t len;
+    const void *p = ht_durable_get(d, "k5", &len);
+    picky_test(t, "ht_durable_get() sees the replayed values");
+    picky_assert(t, p != NULL && len == sizeof(int) && memcpy(&v, p, sizeof(v)) && v == 1000
+                 && ht_durable_get(d, "k6", &len) == NULL && ht_durable_get(d, "tail", &len) != NULL);
+
+    p = ht_durable_get(d, "k99", &len);
+    picky_test(t, "ht_durable_get() reads values from the snapshot");
+    picky_assert(t, p != NULL && memcpy(&v, p, sizeof(v)) && v == 99);
+
+    ht_durable_close(d);
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s/snapshot", dir);
+    struct stat st;
+    stat(path, &st);
+
+    picky_test(t, "ht_durable_open() rejects a truncated snapshot");
+    truncate(path, st.st_size - 6);
+    picky_assert(t, ht_durable_open(dir) == NULL);
+
+    picky_test(t, "ht_durable_open() rejects a key length past the end of the snapshot");
+    truncate(path, st.st_size);
+    uint32_t huge = 0xfffffff0u;
+    fd = open(path, O_WRONLY);
+    pwrite(fd, &huge, sizeof(huge), 16);
+    close(fd);
+    picky_assert(t, ht_durable_open(dir) == NULL);
+
+    unlink(path);
+    unlink(wal);
+    rmdir(dir);
+}
+
+#define DURABLE_THREADS 4
+#define DURABLE_KEYS 2000
+
+typedef struct {
+    DurableMap *d;
+    int id;
+} durable_writer_arg;
+
+static atomic_int durable_committed;
+
+static void *durable_writer(void *arg) {
+    durable_writer_arg *w = (durable_writer_arg *)arg;
+    char key[32];
+    for(int i = 0; i < DURABLE_KEYS; i++) {
+        snprintf(key, sizeof(key), "w%d-%d", w->id, i);
+        ht_durable_set(w->d, key, &i, sizeof(i));
+        ht_durable_commit(w->d);
+        atomic_fetch_add(&durable_committed, 1);
+    }
+    return NULL;
+}
+
+void map_durable_checkpoint(T *t) {
+    char dir[] = "/tmp/ht_wal_XXXXXX";
+    mkdtemp(dir);
+    DurableMap *d = ht_durable_open(dir);
+
+    // Checkpoints race group commits: a leader may still be writing the
+    // log when the checkpoint truncates it. Stopping halfway leaves the
+    // rest of the keys in the log after the last checkpoint
+    pthread_t threads[DURABLE_THREADS];
+    durable_writer_arg args[DURABLE_THREADS];
+    atomic_store(&durable_committed, 0);
+    for(int i = 0; i < DURABLE_THREADS; i++) {
+        args[i] = (durable_writer_arg){ d, i };
+        pthread_create(&threads[i], NULL, durable_writer, &args[i]);
+    }
+    int failed = 0;
+    while(atomic_load(&durable_committed) < DURABLE_THREADS * DURABLE_KEYS / 2) {
+        failed |= ht_durable_checkpoint(d) < 0;
+    }
+    for(int i = 0; i < DURABLE_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    picky_test(t, "ht_durable_checkpoint() succeeds alongside commits");
+    picky_int_toBe(t, 0, failed);
+    ht_durable_close(d);
+
+    d = ht_durable_open(dir);
+    picky_test(t, "ht_durable_open() recovers every key committed around checkpoints");
+    int found = 0;
+    char key[32];
+    size_t len;
+    for(int w = 0; w < DURABLE_THREADS; w++) {
+        for(int i = 0; i < DURABLE_KEYS; i++) {
+            snprintf(key, sizeof(key), "w%d-%d", w, i);
+            const int *p = ht_durable_get(d, key, &len);
+            if(p != NULL && len == sizeof(int) && *p == i) found++;
+        }
+    }
+    picky_int_toBe(t, DURABLE_THREADS * DURABLE_KEYS, found);
+    ht_durable_close(d);
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s/snapshot", dir);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/wal", dir);
+    unlink(path);
+    rmdir(dir);
+}
+
+void map_compact(T *t) {
+    CompactMap *m = ht_compact_new(4);
+    char key[24];
+
+    picky_test(t, "ht_compact_new() not null");
+    picky_assertNotNull(t, m);
+
+    picky_test(t, "ht_compact_slot is 8 bytes");
+    picky_int_toBe(t, 8, (int)sizeof(ht_compact_slot));
+
+    for(int i = 0; i < 3000; i++) {
+        snprintf(key, sizeof(key), "compact-%d", i);
+        ht_compact_set(m, key, (void *)(intptr_t)(i + 1));
+    }
+    ht_compact_set(m, "compact-10", (void *)(intptr_t)-1);
+
+    picky_test(t, "ht_compact_set() copies keys and counts distinct ones");
+    picky_int_toBe(t, 3000, (int)ht_compact_length(m));
+
+    picky_test(t, "ht_compact_get() finds every key after expands");
+    int ok = 0;
+    for(int i = 0; i < 3000; i++) {
+        snprintf(key, sizeof(key), "compact-%d", i);
+        if(ht_compact_get(m, key) == (void *)(intptr_t)(i == 10 ? -1 : i + 1)) ok++;
+    }
+    picky_int_toBe(t, 3000, ok);
+
+    picky_test(t, "ht_compact_get() returns NULL to non existent key");
+    picky_assert(t, ht_compact_get(m, "compact-x") == NULL);
+
+    ht_compact_destroy(m);
+}
+
+void map_inline(T *t) {
+    InlineMap *m = ht_inline_new(4);
+    const char *long_key = "a-key-longer-than-the-inline-buffer";
+
+    picky_test(t, "ht_inline_new() not null");
+    picky_assertNotNull(t, m);
+
+    picky_test(t, "ht_inline_entry fits half a cache line");
+    picky_int_toBe(t, 32, (int)sizeof(ht_inline_entry));
+
+    char key[16];
+    for(int i = 0; i < 2000; i++) {
+        snprintf(key, sizeof(key), "id%d", i);
+        ht_inline_set(m, key, (void *)(intptr_t)(i + 1));
+    }
+    ht_inline_set(m, long_key, (void *)(intptr_t)-1);
+
+    picky_test(t, "ht_inline_set() copies short keys inline");
+    int ok = 0;
+    for(int i = 0; i < 2000; i++) {
+        snprintf(key, sizeof(key), "id%d", i);
+        if(ht_inline_get(m, key) == (void *)(intptr_t)(i + 1)) ok++;
+    }
+    picky_int_toBe(t, 2000, ok);
+
+    picky_test(t, "ht_inline_get() finds keys stored out of line");
+    picky_assert(t, ht_inline_get(m, long_key) == (void *)(intptr_t)-1 && ht_inline_length(m) == 2001);
+
+    picky_test(t, "ht_inline_get() returns NULL to non existent key");
+    picky_assert(t, ht_inline_get(m, "id-missing") == NULL);
+
+    ht_inline_destroy(m);
+}
+
+void map_multimap(T *t) {
+    MultiMap *mm = ht_multimap_new(4);
+
+    picky_test(t, "ht_multimap_new() not null");
+    picky_assertNotNull(t, mm);
+
+    const char *groups[] = { "group0", "group1", "group2" };
+    for(int i = 0; i < 3000; i++) {
+        ht_multimap_append(mm, groups[i % 3], (void *)(intptr_t)i);
+    }
+    ht_multimap_append(mm, "single", NULL);
+
+    picky_test(t, "ht_multimap_count() counts the values of each key");
+    picky_assert(t, ht_multimap_count(mm, "group0") == 1000 && ht_multimap_count(mm, "single") == 1 &&
+                    ht_multimap_count(mm, "missing") == 0 && ht_multimap_length(mm) == 4);
+
+    picky_test(t, "ht_multimap_next() walks a group in insertion order");
+    MultiMapIter it = ht_multimap_range(mm, "group1");
+    void *value;
+    int ok = 0, n = 0;
+    while(ht_multimap_next(&it, &value)) {
+        if((intptr_t)value == 3 * n + 1) ok++;
+        n++;
+    }
+    picky_assert(t, ok == 1000 && n == 1000);
+
+    picky_test(t, "ht_multimap_next() sees values appended after the end");
+    ht_multimap_append(mm, "group1", (void *)(intptr_t)-1);
+    picky_assert(t, ht_multimap_next(&it, &value) == 1 && (intptr_t)value == -1 && ht_multimap_next(&it, &value) == 0);
+
+    picky_test(t, "ht_multimap_range() is empty for a missing key");
+    it = ht_multimap_range(mm, "missing");
+    picky_assert(t, ht_multimap_next(&it, &value) == 0);
+
+    ht_multimap_destroy(mm);
+}
+
+void map_hash_batch(T *t) {
+    enum { N = 203 };
+    char *keys[N];
+    size_t lens[N];
+    uint64_t with_lens[N], without_lens[N];
+
+    // Lengths 0..66 so lanes run out at every offset inside an 8 byte word
+    for(int i = 0; i < N; i++) {
+        lens[i] = (size_t)(i * 7 % 67);
+        keys[i] = (char *)malloc(lens[i] + 1);
+        for(size_t j = 0; j < lens[i]; j++) {
+            keys[i][j] = (char)(' ' + (i * 31 + j * 17) % 200);
+        }
+        keys[i][lens[i]] = '\0';
+    }
+
+    ht_hash_batch((const char **)keys, lens, N, with_lens);
+    ht_hash_batch((const char **)keys, NULL, N, without_lens);
+
+    picky_test(t, "ht_hash_batch() matches the map hash");
+    int ok = 0;
+    for(int i = 0; i < N; i++) {
+        if(with_lens[i] == ht__hash(keys[i]) && without_lens[i] == with_lens[i]) ok++;
+    }
+    picky_int_toBe(t, N, ok);
+
+    Map *m = ht_new_map(16);
+    for(int i = 0; i < N; i += 2) {
+        ht_set(m, keys[i], keys[i]);
+    }
+
+    picky_test(t, "ht_get_batch() finds present keys and NULLs missing ones");
+    void *values[N];
+    size_t found = ht_get_batch(m, (const char **)keys, N, values);
+    size_t present = 0;
+    ok = 0;
+    for(int i = 0; i < N; i++) {
+        if(values[i] == ht_get(m, keys[i])) ok++;
+        if(values[i] != NULL) present++;
+    }
+    picky_assert(t, ok == N && found == present && present > ht_length(m) / 2);
+
+    ht_free(m);
+    for(int i = 0; i < N; i++) {
+        free(keys[i]);
+    }
+}
+
 int main(int argc, char **argv) {
 
     picky_describe("Map creation", map_creation);
     picky_describe("Map set/get", map_insertion);
     picky_describe("Map expand", map_expand);
+    picky_describe("Map rehash", map_rehash);
+    picky_describe("Map interning", map_intern);
+    picky_describe("Map snapshots", map_snapshot);
+    picky_describe("Map parallel build", map_parallel);
+    picky_describe("Map memory placement", map_mem_opts);
+    picky_describe("Map over TSV files", map_tsv);
+    picky_describe("Map concurrent inserts", map_atomic);
+    picky_describe("Map on disk", map_disk);
+    picky_describe("Map delete", map_delete);
+    picky_describe("Map write-ahead log", map_durable);
+    picky_describe("Map checkpoints under load", map_durable_checkpoint);
+    picky_describe("Compact map", map_compact);
+    picky_describe("Inline key map", map_inline);
+    picky_describe("Multimap", map_multimap);
+    picky_describe("Batched hashing", map_hash_batch);
 }
\ No newline at end of file
@@ -0,0 +1,459 @@
+// gcc -O2 -I saul -I ticky tests/saul_bench.c -o saul_bench -lpthread -lm
+// ./saul_bench [filter]   runs only the benchmarks whose name contains filter
+#define TICKY_IMPLEMENTATION
+#define SAUL_IMPLEMENTATION
+#include <saul.h>
+#include <ticky.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifndef SAUL_BENCH_SIZES
+#define SAUL_BENCH_SIZES { 128, 256, 512, 1024 }
+#endif
+
+static const char *filter;
+static ticky_stats *stats;
+
+static Matrix *a;
+static Matrix *b;
+static volatile float sink;
+
+static void fill(Matrix *m) {
+    for(int i = 0; i < m->rows; i++) {
+        for(int j = 0; j < m->cols; j++) {
+            SAUL_AT(m, i, j) = (float)((i * 7 + j * 13) % 17) / 17.0f - 0.5f;
+        }
+    }
+}
+
+// The pre-blocking implementation: i-j-k through the checked accessors
+void bench_mul_naive() {
+    Matrix *m3 = saul_new_matrix(a->rows, b->cols);
+    for(int i = 0; i < a->rows; i++) {
+        for(int j = 0; j < b->cols; j++) {
+            for(int k = 0; k < a->cols; k++) {
+                float v = saul_get_value_by_index(m3, i, j) + saul_get_value_by_index(a, i, k) * saul_get_value_by_index(b, k, j);
+                saul_matrix_set_value(m3, i, j, v);
+            }
+        }
+    }
+    sink += SAUL_AT(m3, 0, 0);
+    saul_free_matrix(m3);
+}
+
+void bench_mul() {
+    Matrix *m3 = saul_matrix_mul(a, b);
+    sink += SAUL_AT(m3, 0, 0);
+    saul_free_matrix(m3);
+}
+
+static Matrix *c;
+
+void bench_mul_into() {
+    saul_matrix_mul_into(a, b, c);
+    sink += SAUL_AT(c, 0, 0);
+}
+
+static int *piv;
+
+// Factors a fresh copy of a into c each call
+void bench_lu() {
+    for(int i = 0; i < a->rows; i++) {
+        memcpy(&SAUL_AT(c, i, 0), &SAUL_AT(a, i, 0), a->cols * sizeof(float));
+    }
+    saul_lu(c, piv);
+    sink += SAUL_AT(c, 0, 0);
+}
+
+void bench_cholesky() {
+    for(int i = 0; i < a->rows; i++) {
+        memcpy(&SAUL_AT(c, i, 0), &SAUL_AT(a, i, 0), a->cols * sizeof(float));
+    }
+    saul_cholesky(c);
+    sink += SAUL_AT(c, 0, 0);
+}
+
+static float *tau;
+
+void bench_qr() {
+    for(int i = 0; i < a->rows; i++) {
+        memcpy(&SAUL_AT(c, i, 0), &SAUL_AT(a, i, 0), a->cols * sizeof(float));
+    }
+    saul_qr(c, tau);
+    sink += SAUL_AT(c, 0, 0);
+}
+
+static SparseMatrix *sp;
+static float *xv;
+static float *yv;
+
+void bench_spmv() {
+    saul_sparse_spmv(sp, xv, yv);
+    sink += yv[0];
+}
+
+void bench_dense_mv() {
+    saul_matrix_mul_into(a, b, c);
+    sink += SAUL_AT(c, 0, 0);
+}
+
+// Sum every 64x64 block of a into c, the way callers did before views
+void bench_blocks_copy() {
+    Matrix *blk = saul_new_matrix(64, 64);
+    for(int i0 = 0; i0 < a->rows; i0 += 64) {
+        for(int j0 = 0; j0 < a->cols; j0 += 64) {
+            for(int i = 0; i < 64; i++) {
+                for(int j = 0; j < 64; j++) {
+                    saul_matrix_set_value(blk, i, j, saul_get_value_by_index(a, i0 + i, j0 + j));
+                }
+            }
+            saul_matrix_add(c, blk);
+        }
+    }
+    saul_free_matrix(blk);
+    sink += SAUL_AT(c, 0, 0);
+}
+
+void bench_blocks_view() {
+    Matrix blk;
+    for(int i0 = 0; i0 < a->rows; i0 += 64) {
+        for(int j0 = 0; j0 < a->cols; j0 += 64) {
+            saul_view_into(&blk, a, i0, j0, 64, 64);
+            saul_matrix_add(c, &blk);
+        }
+    }
+    sink += SAUL_AT(c, 0, 0);
+}
+
+static void scale_each(Matrix *m, int i, int j) {
+    SAUL_AT(m, i, j) *= 0.999f;
+}
+
+void bench_scale_for_each() {
+    saul_matrix_for_each(a, scale_each);
+}
+
+void bench_scale_map() {
+    SAUL_MAP(a, x, x * 0.999f);
+}
+
+void bench_scale() {
+    saul_matrix_scale(a, 0.999f);
+}
+
+void bench_expf_loop() {
+    SAUL_MAP(c, x, expf(x));
+}
+
+void bench_exp() {
+    saul_matrix_exp(c);
+}
+
+void bench_add() {
+    saul_matrix_add(a, b);
+}
+
+static MatrixF64 *da;
+static MatrixF64 *db;
+static MatrixF64 *dc;
+static MatrixI32 *ia;
+static MatrixI32 *ib;
+
+void bench_mul_f64() {
+    saul_f64_matrix_mul_into(da, db, dc);
+    sink += (float)SAUL_AT(dc, 0, 0);
+}
+
+void bench_add_f64() {
+    saul_f64_matrix_add(da, db);
+}
+
+void bench_add_i32() {
+    saul_i32_matrix_add(ia, ib);
+}
+
+static char *label(const char *fmt, int n) {
+    char *s = (char *)malloc(96);
+    snprintf(s, 96, fmt, n, n, n);
+    return s;
+}
+
+// Reports GFLOP/s for fn doing flops floating point operations per call
+static void bench_gflops(const char *name, func fn, double flops) {
+    if(filter != NULL && strstr(name, filter) == NULL) {
+        return;
+    }
+    ticky_bench(stats, (char *)name, fn, NULL);
+    double avg = stats->results[stats->n_results - 1]->avg;
+    printf("%s...%.2f GFLOP/s\n", name, flops / avg / 1e9);
+}
+
+// Reports GFLOP/s for an n x n x n product
+static void bench_flops(const char *name, func fn, int n) {
+    bench_gflops(name, fn, 2.0 * n * n * n);
+}
+
+static void mul_bench() {
+    int sizes[] = SAUL_BENCH_SIZES;
+
+    printf("\n[matrix multiply]\n");
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int n = sizes[s];
+        a = saul_new_matrix(n, n);
+        b = saul_new_matrix(n, n);
+        fill(a);
+        fill(b);
+
+        if(n <= 512) {
+            bench_flops(label("mul naive %dx%dx%d", n), bench_mul_naive, n);
+        }
+        bench_flops(label("mul %dx%dx%d", n), bench_mul, n);
+
+        saul_free_matrix(a);
+        saul_free_matrix(b);
+    }
+}
+
+// Same work on every ISA level the CPU supports
+static void isa_bench() {
+    const char *names[] = { "scalar", "sse2", "avx2", "avx512" };
+    int n = 1024;
+    a = saul_new_matrix(n, n);
+    b = saul_new_matrix(n, n);
+    fill(a);
+    fill(b);
+
+    printf("\n[ISA levels, %dx%d]\n", n, n);
+    for(int isa = SAUL_ISA_SCALAR; isa <= SAUL_ISA_AVX512; isa++) {
+        if(saul_set_isa((saul_isa)isa) < 0) {
+            continue;
+        }
+        char *name = (char *)malloc(64);
+        snprintf(name, 64, "mul isa=%s", names[isa]);
+        bench_flops(name, bench_mul, n);
+
+        name = (char *)malloc(64);
+        snprintf(name, 64, "add isa=%s", names[isa]);
+        if(filter == NULL || strstr(name, filter) != NULL) {
+            ticky_bench(stats, name, bench_add, NULL);
+            printf("%s...%.2f GB/s\n", name, 3.0 * n * n * sizeof(float) / stats->results[stats->n_results - 1]->avg / 1e9);
+        }
+    }
+    saul_init();
+
+    saul_free_matrix(a);
+    saul_free_matrix(b);
+}
+
+// Allocating result vs reusing a caller-owned one, small sizes where it shows
+static void into_bench() {
+    int sizes[] = { 8, 32, 128 };
+
+    printf("\n[allocating vs _into]\n");
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int n = sizes[s];
+        a = saul_new_matrix(n, n);
+        b = saul_new_matrix(n, n);
+        c = saul_new_matrix(n, n);
+        fill(a);
+        fill(b);
+
+        bench_flops(label("mul alloc %dx%dx%d", n), bench_mul, n);
+        bench_flops(label("mul_into %dx%dx%d", n), bench_mul_into, n);
+
+        saul_free_matrix(a);
+        saul_free_matrix(b);
+        saul_free_matrix(c);
+    }
+}
+
+static void lu_bench() {
+    int sizes[] = SAUL_BENCH_SIZES;
+
+    printf("\n[factorizations]\n");
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int n = sizes[s];
+        a = saul_new_matrix(n, n);
+        c = saul_new_matrix(n, n);
+        piv = (int *)malloc(n * sizeof(int));
+        fill(a);
+        for(int i = 0; i < n; i++) SAUL_AT(a, i, i) += n;
+
+        bench_gflops(label("lu %dx%d", n), bench_lu, 2.0 / 3.0 * n * n * n);
+
+        // Read as its lower triangle, the boosted a is diagonally dominant, so SPD
+        bench_gflops(label("cholesky %dx%d", n), bench_cholesky, 1.0 / 3.0 * n * n * n);
+
+        tau = (float *)malloc(n * sizeof(float));
+        bench_gflops(label("qr %dx%d", n), bench_qr, 4.0 / 3.0 * n * n * n);
+        free(tau);
+
+        saul_free_matrix(a);
+        saul_free_matrix(c);
+        free(piv);
+    }
+}
+
+// 1% dense; both report flops on nonzeros only, so the ratio is the speedup
+static void sparse_bench() {
+    int n = 4096;
+    unsigned seed = 1;
+    a = saul_new_matrix(n, n);
+    b = saul_new_matrix(n, 1);
+    c = saul_new_matrix(n, 1);
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < n; j++) {
+            if(rand_r(&seed) % 100 == 0) SAUL_AT(a, i, j) = 1.0f;
+        }
+    }
+    fill(b);
+    sp = saul_sparse_from_dense(a, SAUL_CSR);
+    xv = (float *)malloc(n * sizeof(float));
+    yv = (float *)malloc(n * sizeof(float));
+    for(int j = 0; j < n; j++) xv[j] = SAUL_AT(b, j, 0);
+
+    printf("\n[sparse, %dx%d, nnz=%d]\n", n, n, sp->nnz);
+    bench_gflops(label("spmv csr %d", n), bench_spmv, 2.0 * sp->nnz);
+    bench_gflops(label("dense mv %d", n), bench_dense_mv, 2.0 * sp->nnz);
+
+    saul_sparse_free(sp);
+    free(xv);
+    free(yv);
+    saul_free_matrix(a);
+    saul_free_matrix(b);
+    saul_free_matrix(c);
+}
+
+static void view_bench() {
+    int n = 1024;
+    a = saul_new_matrix(n, n);
+    c = saul_new_matrix(64, 64);
+    fill(a);
+
+    printf("\n[64x64 blocks of %dx%d]\n", n, n);
+    char *names[] = { "blocks copy", "blocks view" };
+    func fns[] = { bench_blocks_copy, bench_blocks_view };
+    for(int k = 0; k < 2; k++) {
+        if(filter != NULL && strstr(names[k], filter) == NULL) {
+            continue;
+        }
+        ticky_bench(stats, names[k], fns[k], NULL);
+        printf("%s...%.2f GB/s\n", names[k], (double)n * n * sizeof(float) / stats->results[stats->n_results - 1]->avg / 1e9);
+    }
+
+    saul_free_matrix(a);
+    saul_free_matrix(c);
+}
+
+// Per-element callback vs inlined macro vs dispatched kernel
+static void map_bench() {
+    int n = 1024;
+    a = saul_new_matrix(n, n);
+    c = saul_new_matrix(n, n);
+    fill(a);
+
+    printf("\n[elementwise, %dx%d]\n", n, n);
+    char *names[] = { "scale for_each", "scale SAUL_MAP", "scale kernel", "exp expf loop", "exp kernel" };
+    func fns[] = { bench_scale_for_each, bench_scale_map, bench_scale, bench_expf_loop, bench_exp };
+    for(int k = 0; k < 5; k++) {
+        if(filter != NULL && strstr(names[k], filter) == NULL) {
+            continue;
+        }
+        // exp runs on values that stay put: e^0 = 1
+        ticky_bench(stats, names[k], fns[k], NULL);
+        printf("%s...%.2f Gelem/s\n", names[k], (double)n * n / stats->results[stats->n_results - 1]->avg / 1e9);
+        SAUL_MAP(c, x, 0.0f);
+    }
+
+    saul_free_matrix(a);
+    saul_free_matrix(c);
+}
+
+// The same work on each element type the template stamps out
+static void types_bench() {
+    int n = 512;
+    a = saul_new_matrix(n, n);
+    b = saul_new_matrix(n, n);
+    c = saul_new_matrix(n, n);
+    da = saul_f64_new_matrix(n, n);
+    db = saul_f64_new_matrix(n, n);
+    dc = saul_f64_new_matrix(n, n);
+    ia = saul_i32_new_matrix(n, n);
+    ib = saul_i32_new_matrix(n, n);
+    fill(a);
+    fill(b);
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < n; j++) {
+            SAUL_AT(da, i, j) = SAUL_AT(a, i, j);
+            SAUL_AT(db, i, j) = SAUL_AT(b, i, j);
+            SAUL_AT(ib, i, j) = (i + j) % 3 - 1;
+        }
+    }
+
+    printf("\n[element types, %dx%d]\n", n, n);
+    bench_flops(label("mul_into f32 %dx%dx%d", n), bench_mul_into, n);
+    bench_flops(label("mul_into f64 %dx%dx%d", n), bench_mul_f64, n);
+    char *names[] = { "add f32", "add f64", "add i32" };
+    func fns[] = { bench_add, bench_add_f64, bench_add_i32 };
+    size_t sizes[] = { sizeof(float), sizeof(double), sizeof(int32_t) };
+    for(int k = 0; k < 3; k++) {
+        if(filter != NULL && strstr(names[k], filter) == NULL) {
+            continue;
+        }
+        ticky_bench(stats, names[k], fns[k], NULL);
+        printf("%s...%.2f GB/s\n", names[k], 3.0 * n * n * sizes[k] / stats->results[stats->n_results - 1]->avg / 1e9);
+    }
+
+    saul_free_matrix(a);
+    saul_free_matrix(b);
+    saul_free_matrix(c);
+    saul_f64_free_matrix(da);
+    saul_f64_free_matrix(db);
+    saul_f64_free_matrix(dc);
+    saul_i32_free_matrix(ia);
+    saul_i32_free_matrix(ib);
+}
+
+// Scaling over the pool, 1 thread up to one per online CPU
+static void thread_bench() {
+    int n = 1024;
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    a = saul_new_matrix(n, n);
+    b = saul_new_matrix(n, n);
+    fill(a);
+    fill(b);
+
+    printf("\n[threads, %dx%d, %ld online CPUs]\n", n, n, online);
+    for(int t = 1; t <= (online > 2 ? online : 2); t *= 2) {
+        saul_set_num_threads(t);
+        bench_flops(label("mul threads=%d", t), bench_mul, n);
+        char *name = label("add threads=%d", t);
+        if(filter == NULL || strstr(name, filter) != NULL) {
+            ticky_bench(stats, name, bench_add, NULL);
+            printf("%s...%.2f GB/s\n", name, 3.0 * n * n * sizeof(float) / stats->results[stats->n_results - 1]->avg / 1e9);
+        }
+    }
+    saul_set_num_threads(1);
+
+    saul_free_matrix(a);
+    saul_free_matrix(b);
+}
+
+int main(int argc, char **argv) {
+    filter = argc > 1 ? argv[1] : NULL;
+    stats = ticky_new_stats();
+
+    mul_bench();
+    isa_bench();
+    into_bench();
+    lu_bench();
+    sparse_bench();
+    view_bench();
+    map_bench();
+    types_bench();
+    thread_bench();
+
+    printf("\n");
+    ticky_plot(stats);
+}
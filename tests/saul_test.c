@@ -2,6 +2,7 @@
 #define SAUL_IMPLEMENTATION
 #include <saul.h>
 #include <picky.h>
+#include <math.h>
 
 
 
@@ -19,11 +20,14 @@ void matrix_setup_test(T *t) {
     picky_int_toBe(t, 4, m->cols);
 
 
+    picky_test(t, "saul_new_matrix() pads rows to an aligned stride");
+    picky_assert(t, m->stride >= m->cols && m->stride % SAUL_ALIGN == 0 && ((uintptr_t)m->items & 63) == 0);
+
     saul_free_matrix(m);
 }
 
 void each(Matrix *m, int i, int j) {
-    m->items[i][j] = 1;
+    SAUL_AT(m, i, j) = 1;
 }
 
 void matrix_utilities_test(T *t) {
@@ -35,7 +39,7 @@ void matrix_utilities_test(T *t) {
 
     picky_test(t, "saul_matrix_set_value()");
     saul_matrix_set_value(m, i, j, 4.5f);
-    picky_float_toBe(t, 4.5f, m->items[i][j]);
+    picky_float_toBe(t, 4.5f, SAUL_AT(m, i, j));
 
 
     picky_test(t, "saul_get_value_by_index()");
@@ -44,7 +48,7 @@ void matrix_utilities_test(T *t) {
 
     picky_test(t, "saul_matrix_for_each() set every value to 1.0");
     saul_matrix_for_each(m, each);
-    picky_float_toBe(t, 1.0f, m->items[0][0]);
+    picky_float_toBe(t, 1.0f, SAUL_AT(m, 0, 0));
 
     picky_test(t, "saul_check_boundaries()");
     picky_assert(t, saul_check_boundaries(m, 6, 6) < 0);
@@ -96,6 +100,12 @@ void matrix_operations_test(T *t) {
     saul_matrix_transpose(&m4);
     picky_assert(t, m4->rows == 2 && m4->cols == 3);
 
+    picky_test(t, "saul_matrix_transpose() rejects a view");
+    Matrix *vt = saul_view(m4, 0, 0, 2, 1);
+    Matrix *vp = vt;
+    picky_assert(t, saul_matrix_transpose(&vp) == -1 && vp == vt && vt->rows == 2);
+    saul_free_matrix(vt);
+
     saul_matrix_set_value(m4, 0, 0, 2);
     saul_matrix_set_value(m4, 0, 1, -3);
     saul_matrix_set_value(m4, 0, 2, 10);
@@ -112,8 +122,972 @@ void matrix_operations_test(T *t) {
     saul_free_matrix(m4);
 }
 
+static void fill_random(Matrix *m, unsigned *seed) {
+    for(int i = 0; i < m->rows; i++) {
+        for(int j = 0; j < m->cols; j++) {
+            *seed = *seed * 1103515245u + 12345u;
+            SAUL_AT(m, i, j) = (float)((*seed >> 16) % 2001) / 1000.0f - 1.0f;
+        }
+    }
+}
+
+// Largest |c - a*b| against a double precision triple loop, relative to k
+static double naive_mul_error(Matrix *a, Matrix *b, Matrix *c) {
+    double worst = 0;
+    for(int i = 0; i < a->rows; i++) {
+        for(int j = 0; j < b->cols; j++) {
+            double sum = 0;
+            for(int k = 0; k < a->cols; k++) {
+                sum += (double)SAUL_AT(a, i, k) * SAUL_AT(b, k, j);
+            }
+            double err = fabs(sum - SAUL_AT(c, i, j));
+            if(err > worst) worst = err;
+        }
+    }
+    return worst / (a->cols > 0 ? a->cols : 1);
+}
+
+void matrix_gemm_test(T *t) {
+    // Odd sizes, plus sizes that cross the MC/KC blocks and leave edge tiles
+    int sizes[][3] = { {1, 1, 1}, {7, 5, 3}, {37, 53, 29}, {101, 300, 67}, {200, 257, 131} };
+    unsigned seed = 42;
+    int ok = 0;
+
+    picky_test(t, "saul_matrix_mul() matches the naive product on odd sizes");
+    for(int s = 0; s < 5; s++) {
+        Matrix *a = saul_new_matrix(sizes[s][0], sizes[s][1]);
+        Matrix *b = saul_new_matrix(sizes[s][1], sizes[s][2]);
+        fill_random(a, &seed);
+        fill_random(b, &seed);
+
+        Matrix *c = saul_matrix_mul(a, b);
+        if(c != NULL && c->rows == a->rows && c->cols == b->cols && naive_mul_error(a, b, c) < 1e-5) ok++;
+
+        saul_free_matrix(a);
+        saul_free_matrix(b);
+        saul_free_matrix(c);
+    }
+    picky_int_toBe(t, 5, ok);
+
+    picky_test(t, "saul_private_gemm() handles strided (transposed) operands, alpha and beta");
+    Matrix *at = saul_new_matrix(45, 33);   // A^T, A is 33 x 45
+    Matrix *b = saul_new_matrix(45, 19);
+    Matrix *c = saul_new_matrix(33, 19);
+    Matrix *ref = saul_new_matrix(33, 19);
+    fill_random(at, &seed);
+    fill_random(b, &seed);
+    fill_random(c, &seed);
+    for(int i = 0; i < 33; i++) {
+        for(int j = 0; j < 19; j++) {
+            double sum = 0;
+            for(int k = 0; k < 45; k++) sum += (double)SAUL_AT(at, k, i) * SAUL_AT(b, k, j);
+            SAUL_AT(ref, i, j) = (float)(2.0 * sum - 0.5 * SAUL_AT(c, i, j));
+        }
+    }
+    saul_private_gemm(33, 19, 45, 2.0f, at->items, 1, at->stride, b->items, b->stride, 1, -0.5f, c->items, c->stride);
+    double worst = 0;
+    for(int i = 0; i < 33; i++) {
+        for(int j = 0; j < 19; j++) {
+            double err = fabs(SAUL_AT(ref, i, j) - SAUL_AT(c, i, j));
+            if(err > worst) worst = err;
+        }
+    }
+    picky_assert(t, worst < 1e-4);
+
+    saul_free_matrix(at);
+    saul_free_matrix(b);
+    saul_free_matrix(c);
+    saul_free_matrix(ref);
+}
+
+static float max_abs_diff(Matrix *a, Matrix *b) {
+    float worst = 0;
+    for(int i = 0; i < a->rows; i++) {
+        for(int j = 0; j < a->cols; j++) {
+            float d = fabsf(SAUL_AT(a, i, j) - SAUL_AT(b, i, j));
+            if(d > worst) worst = d;
+        }
+    }
+    return worst;
+}
+
+void matrix_dispatch_test(T *t) {
+    unsigned seed = 7;
+    Matrix *a = saul_new_matrix(45, 71);
+    Matrix *b = saul_new_matrix(71, 39);
+    Matrix *add = saul_new_matrix(45, 71);
+    fill_random(a, &seed);
+    fill_random(b, &seed);
+    fill_random(add, &seed);
+
+    saul_init();
+    saul_isa best = saul_get_isa();
+
+    picky_test(t, "saul_set_isa() always accepts the scalar path");
+    picky_int_toBe(t, 0, saul_set_isa(SAUL_ISA_SCALAR));
+
+    Matrix *sum_ref = saul_new_matrix(45, 71);
+    Matrix *diff_ref = saul_new_matrix(45, 71);
+    saul_matrix_add(sum_ref, a);
+    saul_matrix_add(sum_ref, add);
+    saul_matrix_add(diff_ref, a);
+    saul_matrix_sub(diff_ref, add);
+    Matrix *mul_ref = saul_matrix_mul(a, b);
+
+    picky_test(t, "saul_matrix_add()/sub() keep fractions");
+    picky_assert(t, fabsf(SAUL_AT(sum_ref, 3, 5) - (SAUL_AT(a, 3, 5) + SAUL_AT(add, 3, 5))) < 1e-6f);
+
+    picky_test(t, "every supported ISA matches the scalar path");
+    int ok = 1;
+    for(int isa = SAUL_ISA_SSE2; isa <= SAUL_ISA_AVX512; isa++) {
+        if(saul_set_isa((saul_isa)isa) < 0) {
+            continue;
+        }
+        Matrix *sum = saul_new_matrix(45, 71);
+        Matrix *diff = saul_new_matrix(45, 71);
+        saul_matrix_add(sum, a);
+        saul_matrix_add(sum, add);
+        saul_matrix_add(diff, a);
+        saul_matrix_sub(diff, add);
+        Matrix *mul = saul_matrix_mul(a, b);
+
+        if(max_abs_diff(sum, sum_ref) != 0 || max_abs_diff(diff, diff_ref) != 0 || max_abs_diff(mul, mul_ref) > 1e-4f) {
+            ok = 0;
+        }
+        saul_free_matrix(sum);
+        saul_free_matrix(diff);
+        saul_free_matrix(mul);
+    }
+    picky_assert(t, ok);
+
+    picky_test(t, "saul_init() picks the best ISA again");
+    saul_init();
+    picky_assert(t, saul_get_isa() == best);
+
+    saul_free_matrix(a);
+    saul_free_matrix(b);
+    saul_free_matrix(add);
+    saul_free_matrix(sum_ref);
+    saul_free_matrix(diff_ref);
+    saul_free_matrix(mul_ref);
+}
+
+void matrix_threads_test(T *t) {
+    unsigned seed = 11;
+    Matrix *a = saul_new_matrix(301, 257);
+    Matrix *b = saul_new_matrix(257, 283);
+    Matrix *big = saul_new_matrix(400, 300);
+    fill_random(a, &seed);
+    fill_random(b, &seed);
+    fill_random(big, &seed);
+
+    saul_set_num_threads(1);
+    Matrix *mul_ref = saul_matrix_mul(a, b);
+    Matrix *sum_ref = saul_new_matrix(400, 300);
+    saul_matrix_add(sum_ref, big);
+    saul_matrix_add(sum_ref, big);
+
+    picky_test(t, "saul_set_num_threads() sizes the pool");
+    saul_set_num_threads(4);
+    picky_int_toBe(t, 4, saul_get_num_threads());
+
+    picky_test(t, "threaded saul_matrix_mul() matches one thread");
+    Matrix *mul = saul_matrix_mul(a, b);
+    picky_assert(t, max_abs_diff(mul, mul_ref) == 0);
+
+    picky_test(t, "threaded saul_matrix_add()/sub() match one thread");
+    Matrix *sum = saul_new_matrix(400, 300);
+    saul_matrix_add(sum, big);
+    saul_matrix_add(sum, big);
+    int same = max_abs_diff(sum, sum_ref) == 0;
+    saul_matrix_sub(sum, big);
+    picky_assert(t, same && max_abs_diff(sum, big) == 0);
+
+    picky_test(t, "the pool can be shrunk back");
+    saul_set_num_threads(1);
+    picky_int_toBe(t, 1, saul_get_num_threads());
+
+    saul_free_matrix(a);
+    saul_free_matrix(b);
+    saul_free_matrix(big);
+    saul_free_matrix(mul_ref);
+    saul_free_matrix(sum_ref);
+    saul_free_matrix(mul);
+    saul_free_matrix(sum);
+}
+
+void matrix_into_test(T *t) {
+    unsigned seed = 5;
+    Matrix *a = saul_new_matrix(37, 23);
+    Matrix *b = saul_new_matrix(23, 41);
+    Matrix *bt = saul_new_matrix(41, 23);
+    Matrix *c = saul_new_matrix(37, 41);
+    fill_random(a, &seed);
+    fill_random(b, &seed);
+
+    picky_test(t, "saul_matrix_mul_into() writes into the given matrix");
+    picky_assert(t, saul_matrix_mul_into(a, b, c) == 0 && naive_mul_error(a, b, c) < 1e-4);
+
+    picky_test(t, "saul_matrix_transpose_into() succeeds");
+    picky_assert(t, saul_matrix_transpose_into(b, bt) == 0);
+
+    picky_test(t, "saul_matrix_transpose_into() tiles cover every element");
+    int ok = 1;
+    for(int i = 0; i < b->rows; i++) {
+        for(int j = 0; j < b->cols; j++) {
+            ok &= SAUL_AT(bt, j, i) == SAUL_AT(b, i, j);
+        }
+    }
+    picky_assert(t, ok);
+
+    picky_test(t, "saul_gemm() takes a transposed B");
+    Matrix *ref = saul_matrix_mul(a, b);
+    Matrix *acc = saul_new_matrix(37, 41);
+    saul_matrix_add(acc, ref);
+    picky_assert(t, saul_gemm(2.0f, a, SAUL_NO_TRANS, bt, SAUL_TRANS, 1.0f, acc) == 0);
+
+    picky_test(t, "saul_gemm() accumulates C += 2 * A * (B^T)^T");
+    float err = 0;
+    for(int i = 0; i < acc->rows; i++) {
+        for(int j = 0; j < acc->cols; j++) {
+            err = fmaxf(err, fabsf(SAUL_AT(acc, i, j) - 3 * SAUL_AT(ref, i, j)));
+        }
+    }
+    picky_assert(t, err < 1e-4);
+
+    picky_test(t, "saul_gemm() reads A transposed");
+    Matrix *at = saul_new_matrix(23, 37);
+    saul_matrix_transpose_into(a, at);
+    picky_assert(t, saul_gemm(1.0f, at, SAUL_TRANS, b, SAUL_NO_TRANS, 0.0f, c) == 0 && max_abs_diff(c, ref) < 1e-5);
+
+    picky_test(t, "saul_gemm() rejects mismatched shapes");
+    picky_assert(t, saul_gemm(1.0f, a, SAUL_TRANS, b, SAUL_NO_TRANS, 0.0f, c) < 0);
+
+    picky_test(t, "mul_into/transpose_into reject aliased outputs");
+    picky_assert(t, saul_matrix_mul_into(a, b, a) < 0 && saul_matrix_transpose_into(c, c) < 0);
+
+    picky_test(t, "saul_matrix_add_into()/sub_into() leave their inputs alone");
+    Matrix *d = saul_new_matrix(37, 41);
+    saul_matrix_add_into(c, ref, d);
+    int kept = max_abs_diff(c, ref) < 1e-5;
+    saul_matrix_sub_into(d, ref, d);
+    picky_assert(t, kept && max_abs_diff(d, c) < 1e-5);
+
+    saul_free_matrix(a);
+    saul_free_matrix(b);
+    saul_free_matrix(bt);
+    saul_free_matrix(c);
+    saul_free_matrix(d);
+    saul_free_matrix(at);
+    saul_free_matrix(ref);
+    saul_free_matrix(acc);
+}
+
+void matrix_lu_test(T *t) {
+    unsigned seed = 17;
+    int n = 150;
+    Matrix *a = saul_new_matrix(n, n);
+    Matrix *lu = saul_new_matrix(n, n);
+    Matrix *b = saul_new_matrix(n, 3);
+    Matrix *x = saul_new_matrix(n, 3);
+    int piv[150];
+    fill_random(a, &seed);
+    fill_random(b, &seed);
+    saul_matrix_add(lu, a);
+    saul_matrix_add(x, b);
+
+    picky_test(t, "saul_lu() factors across several panels");
+    picky_int_toBe(t, 0, saul_lu(lu, piv));
+
+    picky_test(t, "saul_lu_solve() succeeds");
+    picky_int_toBe(t, 0, saul_lu_solve(lu, piv, x));
+
+    picky_test(t, "saul_lu_solve() gives A X = B");
+    Matrix *ax = saul_matrix_mul(a, x);
+    picky_assert(t, max_abs_diff(ax, b) < 1e-3);
+
+    picky_test(t, "saul_inverse() times the matrix is the identity");
+    Matrix *inv = saul_inverse(a);
+    Matrix *id = saul_matrix_mul(inv, a);
+    float err = 0;
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < n; j++) {
+            err = fmaxf(err, fabsf(SAUL_AT(id, i, j) - (i == j)));
+        }
+    }
+    picky_assert(t, err < 1e-3);
+
+    picky_test(t, "saul_det() needs a row swap on a zero pivot");
+    Matrix *s = saul_new_matrix(3, 3);
+    float vals[9] = { 0, 2, 1, 1, 1, 1, 2, 1, 3 };
+    for(int i = 0; i < 9; i++) SAUL_AT(s, i / 3, i % 3) = vals[i];
+    picky_assert(t, fabsf(saul_det(s) - (-3.0f)) < 1e-5);
+
+    picky_test(t, "singular matrices are reported");
+    SAUL_AT(s, 2, 0) = 1;
+    SAUL_AT(s, 2, 1) = 3;
+    SAUL_AT(s, 2, 2) = 2;
+    picky_assert(t, saul_det(s) == 0 && saul_inverse(s) == NULL && saul_lu(s, piv) == -2);
+
+    picky_test(t, "saul_lu() rejects non-square input");
+    picky_int_toBe(t, -1, saul_lu(b, piv));
+
+    picky_test(t, "saul_gauss_reduction() terminates on singular input and returns the rank");
+    for(int i = 0; i < 9; i++) SAUL_AT(s, i / 3, i % 3) = vals[i];
+    SAUL_AT(s, 2, 0) = 1;
+    SAUL_AT(s, 2, 1) = 3;
+    SAUL_AT(s, 2, 2) = 2;
+    picky_int_toBe(t, 2, saul_gauss_reduction(&s));
+
+    picky_test(t, "saul_gauss_reduction() leaves row echelon form");
+    picky_assert(t, saul_is_upper_triangular(s) == 0);
+
+    saul_free_matrix(a);
+    saul_free_matrix(lu);
+    saul_free_matrix(b);
+    saul_free_matrix(x);
+    saul_free_matrix(ax);
+    saul_free_matrix(inv);
+    saul_free_matrix(id);
+    saul_free_matrix(s);
+}
+
+void matrix_cholesky_test(T *t) {
+    unsigned seed = 23;
+    int n = 140;
+    Matrix *g = saul_new_matrix(n, n);
+    fill_random(g, &seed);
+    Matrix *gt = saul_new_matrix(n, n);
+    saul_matrix_transpose_into(g, gt);
+    Matrix *a = saul_matrix_mul(g, gt);
+    for(int i = 0; i < n; i++) SAUL_AT(a, i, i) += n;
+
+    // Only the lower triangle is meaningful to saul_cholesky()
+    Matrix *l = saul_new_matrix(n, n);
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < n; j++) {
+            SAUL_AT(l, i, j) = j <= i ? SAUL_AT(a, i, j) : 999.0f;
+        }
+    }
+
+    picky_test(t, "saul_cholesky() factors an SPD matrix across several blocks");
+    picky_int_toBe(t, 0, saul_cholesky(l));
+
+    picky_test(t, "saul_cholesky() leaves the upper triangle alone");
+    int kept = 1;
+    for(int i = 0; i < n; i++) {
+        for(int j = i + 1; j < n; j++) {
+            kept &= SAUL_AT(l, i, j) == 999.0f;
+        }
+    }
+    picky_assert(t, kept);
+
+    picky_test(t, "L L^T rebuilds the matrix");
+    float err = 0;
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j <= i; j++) {
+            double s = 0;
+            for(int k = 0; k <= j; k++) s += (double)SAUL_AT(l, i, k) * SAUL_AT(l, j, k);
+            err = fmaxf(err, fabsf((float)s - SAUL_AT(a, i, j)));
+        }
+    }
+    picky_assert(t, err < 1e-2);
+
+    picky_test(t, "saul_cholesky_solve() succeeds");
+    Matrix *b = saul_new_matrix(n, 4);
+    Matrix *x = saul_new_matrix(n, 4);
+    fill_random(b, &seed);
+    saul_matrix_add(x, b);
+    picky_int_toBe(t, 0, saul_cholesky_solve(l, x));
+
+    picky_test(t, "saul_cholesky_solve() gives A X = B");
+    Matrix *ax = saul_matrix_mul(a, x);
+    picky_assert(t, max_abs_diff(ax, b) < 1e-3);
+
+    picky_test(t, "saul_cholesky() rejects an indefinite matrix");
+    Matrix *s = saul_new_matrix(2, 2);
+    SAUL_AT(s, 0, 0) = 1;
+    SAUL_AT(s, 1, 0) = 2;
+    SAUL_AT(s, 1, 1) = 1;
+    picky_int_toBe(t, -2, saul_cholesky(s));
+
+    saul_free_matrix(g);
+    saul_free_matrix(gt);
+    saul_free_matrix(a);
+    saul_free_matrix(l);
+    saul_free_matrix(b);
+    saul_free_matrix(x);
+    saul_free_matrix(ax);
+    saul_free_matrix(s);
+}
+
+void matrix_qr_test(T *t) {
+    unsigned seed = 29;
+    int m = 200;
+    int n = 90;
+    Matrix *a = saul_new_matrix(m, n);
+    Matrix *r = saul_new_matrix(m, n);
+    float tau[90];
+    fill_random(a, &seed);
+    saul_matrix_add(r, a);
+
+    picky_test(t, "saul_qr() succeeds on a tall matrix");
+    picky_int_toBe(t, 0, saul_qr(r, tau));
+
+    picky_test(t, "saul_qr() gives R with R^T R = A^T A across several panels");
+    for(int i = 0; i < m; i++) {
+        for(int j = 0; j < n && j < i; j++) SAUL_AT(r, i, j) = 0;
+    }
+    Matrix *ata = saul_new_matrix(n, n);
+    Matrix *rtr = saul_new_matrix(n, n);
+    saul_gemm(1.0f, a, SAUL_TRANS, a, SAUL_NO_TRANS, 0.0f, ata);
+    saul_gemm(1.0f, r, SAUL_TRANS, r, SAUL_NO_TRANS, 0.0f, rtr);
+    picky_assert(t, max_abs_diff(ata, rtr) < 1e-3);
+
+    picky_test(t, "saul_lstsq() recovers X from a consistent system");
+    Matrix *x0 = saul_new_matrix(n, 3);
+    fill_random(x0, &seed);
+    Matrix *b = saul_matrix_mul(a, x0);
+    Matrix *x = saul_lstsq(a, b);
+    picky_assert(t, x != NULL && max_abs_diff(x, x0) < 1e-3);
+
+    picky_test(t, "saul_lstsq() residual is orthogonal to the columns of A");
+    fill_random(b, &seed);
+    Matrix *y = saul_lstsq(a, b);
+    Matrix *res = saul_matrix_mul(a, y);
+    saul_matrix_sub(res, b);
+    Matrix *g = saul_new_matrix(n, 3);
+    saul_gemm(1.0f, a, SAUL_TRANS, res, SAUL_NO_TRANS, 0.0f, g);
+    float worst = 0;
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < 3; j++) worst = fmaxf(worst, fabsf(SAUL_AT(g, i, j)));
+    }
+    picky_assert(t, worst < 1e-3);
+
+    picky_test(t, "saul_lstsq() rejects underdetermined and rank-deficient A");
+    Matrix *wide = saul_new_matrix(3, 5);
+    Matrix *bw = saul_new_matrix(3, 1);
+    Matrix *flat = saul_new_matrix(5, 3);
+    Matrix *bf = saul_new_matrix(5, 1);
+    picky_assert(t, saul_lstsq(wide, bw) == NULL && saul_lstsq(flat, bf) == NULL);
+
+    picky_test(t, "saul_lstsq() rejects a column that is a sum of two others");
+    Matrix *dep = saul_new_matrix(m, 3);
+    Matrix *bd = saul_new_matrix(m, 1);
+    for(int i = 0; i < m; i++) {
+        SAUL_AT(dep, i, 0) = SAUL_AT(a, i, 0);
+        SAUL_AT(dep, i, 1) = SAUL_AT(a, i, 1);
+        SAUL_AT(dep, i, 2) = SAUL_AT(a, i, 0) + SAUL_AT(a, i, 1);
+        SAUL_AT(bd, i, 0) = SAUL_AT(a, i, 2);
+    }
+    picky_assert(t, saul_lstsq(dep, bd) == NULL);
+    saul_free_matrix(dep);
+    saul_free_matrix(bd);
+
+    saul_free_matrix(a);
+    saul_free_matrix(r);
+    saul_free_matrix(ata);
+    saul_free_matrix(rtr);
+    saul_free_matrix(x0);
+    saul_free_matrix(b);
+    saul_free_matrix(x);
+    saul_free_matrix(y);
+    saul_free_matrix(res);
+    saul_free_matrix(g);
+    saul_free_matrix(wide);
+    saul_free_matrix(bw);
+    saul_free_matrix(flat);
+    saul_free_matrix(bf);
+}
+
+void matrix_sparse_test(T *t) {
+    int ri[] = { 2, 0, 1, 0, 2, 1 };
+    int ci[] = { 3, 1, 0, 1, 0, 0 };
+    float v[] = { 4.0f, 1.0f, 2.0f, 0.5f, 3.0f, -1.0f };
+
+    picky_test(t, "saul_sparse_from_coo() not null");
+    SparseMatrix *s = saul_sparse_from_coo(3, 4, 6, ri, ci, v, SAUL_CSR);
+    picky_assertNotNull(t, s);
+
+    picky_test(t, "saul_sparse_from_coo() sums duplicates");
+    picky_int_toBe(t, 4, s->nnz);
+
+    picky_test(t, "saul_sparse_from_coo() sorts rows and columns");
+    picky_assert(t, s->ptr[1] == 1 && s->ptr[2] == 2 && s->idx[2] == 0 && s->idx[3] == 3);
+
+    picky_test(t, "saul_sparse_to_dense() puts every entry back");
+    Matrix *d = saul_sparse_to_dense(s);
+    picky_assert(t, SAUL_AT(d, 0, 1) == 1.5f && SAUL_AT(d, 1, 0) == 1.0f && SAUL_AT(d, 2, 0) == 3.0f &&
+                    SAUL_AT(d, 2, 3) == 4.0f && SAUL_AT(d, 1, 1) == 0.0f);
+
+    picky_test(t, "CSC built from COO matches the CSR conversion");
+    SparseMatrix *csc = saul_sparse_from_coo(3, 4, 6, ri, ci, v, SAUL_CSC);
+    SparseMatrix *conv = saul_sparse_convert(s, SAUL_CSC);
+    int same = csc->nnz == conv->nnz;
+    for(int k = 0; same && k < csc->nnz; k++) {
+        same = csc->idx[k] == conv->idx[k] && csc->values[k] == conv->values[k];
+    }
+    picky_assert(t, same && memcmp(csc->ptr, conv->ptr, 5 * sizeof(int)) == 0);
+
+    picky_test(t, "saul_sparse_from_coo() rejects out-of-range indices");
+    int bad[] = { 3 };
+    picky_assert(t, saul_sparse_from_coo(3, 4, 1, bad, ci, v, SAUL_CSR) == NULL);
+
+    unsigned seed = 31;
+    int rows = 700;
+    int cols = 500;
+    Matrix *dense = saul_new_matrix(rows, cols);
+    fill_random(dense, &seed);
+    for(int i = 0; i < rows; i++) {
+        for(int j = 0; j < cols; j++) {
+            // Keep about one entry in five, with a few full rows
+            if(i % 97 != 0 && rand_r(&seed) % 5 != 0) SAUL_AT(dense, i, j) = 0;
+        }
+    }
+    SparseMatrix *a = saul_sparse_from_dense(dense, SAUL_CSR);
+    SparseMatrix *ac = saul_sparse_from_dense(dense, SAUL_CSC);
+
+    picky_test(t, "saul_sparse_from_dense() round-trips through both formats");
+    Matrix *back = saul_sparse_to_dense(a);
+    Matrix *back_c = saul_sparse_to_dense(ac);
+    picky_assert(t, max_abs_diff(back, dense) == 0 && max_abs_diff(back_c, dense) == 0);
+
+    picky_test(t, "saul_sparse_spmv() matches the dense product in both formats");
+    Matrix *x = saul_new_matrix(cols, 1);
+    Matrix *y = saul_new_matrix(rows, 1);
+    Matrix *yc = saul_new_matrix(rows, 1);
+    fill_random(x, &seed);
+    float xv[500];
+    float yv[700];
+    float ycv[700];
+    for(int j = 0; j < cols; j++) xv[j] = SAUL_AT(x, j, 0);
+    saul_matrix_mul_into(dense, x, y);
+    saul_sparse_spmv(a, xv, yv);
+    saul_sparse_spmv(ac, xv, ycv);
+    for(int i = 0; i < rows; i++) {
+        SAUL_AT(yc, i, 0) = fabsf(yv[i] - ycv[i]);
+        SAUL_AT(y, i, 0) -= yv[i];
+    }
+    Matrix *zero = saul_new_matrix(rows, 1);
+    picky_assert(t, max_abs_diff(y, zero) < 1e-4 && max_abs_diff(yc, zero) < 1e-4);
+
+    picky_test(t, "saul_sparse_spmm() matches the dense product in CSR");
+    Matrix *b = saul_new_matrix(cols, 37);
+    Matrix *ref = saul_new_matrix(rows, 37);
+    Matrix *c = saul_new_matrix(rows, 37);
+    fill_random(b, &seed);
+    saul_matrix_mul_into(dense, b, ref);
+    picky_assert(t, saul_sparse_spmm(a, b, c) == 0 && max_abs_diff(c, ref) < 1e-4);
+
+    picky_test(t, "saul_sparse_spmm() matches the dense product in CSC");
+    picky_assert(t, saul_sparse_spmm(ac, b, c) == 0 && max_abs_diff(c, ref) < 1e-4);
+
+    picky_test(t, "threaded CSR products match one thread");
+    float yt[700];
+    Matrix *ct = saul_new_matrix(rows, 37);
+    saul_set_num_threads(4);
+    saul_sparse_spmv(a, xv, yt);
+    saul_sparse_spmm(a, b, ct);
+    saul_set_num_threads(1);
+    picky_assert(t, memcmp(yt, yv, sizeof(yt)) == 0 && max_abs_diff(ct, c) < 1e-4);
+
+    saul_sparse_free(s);
+    saul_sparse_free(csc);
+    saul_sparse_free(conv);
+    saul_sparse_free(a);
+    saul_sparse_free(ac);
+    saul_free_matrix(d);
+    saul_free_matrix(dense);
+    saul_free_matrix(back);
+    saul_free_matrix(back_c);
+    saul_free_matrix(x);
+    saul_free_matrix(y);
+    saul_free_matrix(yc);
+    saul_free_matrix(zero);
+    saul_free_matrix(b);
+    saul_free_matrix(ref);
+    saul_free_matrix(c);
+    saul_free_matrix(ct);
+}
+
+void matrix_view_test(T *t) {
+    unsigned seed = 37;
+    Matrix *m = saul_new_matrix(130, 140);
+    fill_random(m, &seed);
+
+    picky_test(t, "saul_view() not null");
+    Matrix *v = saul_view(m, 10, 20, 30, 40);
+    picky_assertNotNull(t, v);
+
+    picky_test(t, "saul_view() shares the parent's buffer");
+    SAUL_AT(v, 2, 3) = 42.0f;
+    picky_float_toBe(t, 42.0f, SAUL_AT(m, 12, 23));
+
+    picky_test(t, "saul_view() rejects blocks outside the parent");
+    picky_assert(t, saul_view(m, 120, 0, 11, 1) == NULL && saul_view(m, 0, -1, 1, 1) == NULL);
+
+    picky_test(t, "saul_row()/saul_col()/saul_diag() have the right shapes");
+    Matrix *r = saul_row(m, 7);
+    Matrix *c = saul_col(m, 9);
+    Matrix *d = saul_diag(v);
+    picky_assert(t, r->rows == 1 && r->cols == 140 && c->rows == 130 && c->cols == 1 && d->rows == 30);
+
+    picky_test(t, "saul_row()/saul_col()/saul_diag() walk the right elements");
+    picky_assert(t, SAUL_AT(r, 0, 5) == SAUL_AT(m, 7, 5) && SAUL_AT(c, 100, 0) == SAUL_AT(m, 100, 9) &&
+                    SAUL_AT(d, 29, 0) == SAUL_AT(m, 39, 49));
+
+    picky_test(t, "saul_matrix_add_into() between side-by-side views of one matrix");
+    Matrix left;
+    Matrix right;
+    saul_view_into(&left, m, 0, 0, 130, 70);
+    saul_view_into(&right, m, 0, 70, 130, 70);
+    Matrix *expect = saul_new_matrix(130, 70);
+    for(int i = 0; i < 130; i++) {
+        for(int j = 0; j < 70; j++) SAUL_AT(expect, i, j) = SAUL_AT(&left, i, j) + SAUL_AT(&right, i, j);
+    }
+    picky_assert(t, saul_matrix_add_into(&left, &right, &right) == 0 && max_abs_diff(&right, expect) == 0);
+
+    picky_test(t, "saul_gemm() into one view from disjoint views of the same matrix");
+    Matrix a;
+    Matrix b;
+    Matrix out;
+    saul_view_into(&a, m, 0, 0, 60, 50);
+    saul_view_into(&b, m, 60, 0, 50, 70);
+    saul_view_into(&out, m, 0, 70, 60, 70);
+    Matrix *ac = saul_new_matrix(60, 50);
+    Matrix *bc = saul_new_matrix(50, 70);
+    saul_matrix_add(ac, &a);
+    saul_matrix_add(bc, &b);
+    Matrix *ref = saul_matrix_mul(ac, bc);
+    picky_assert(t, saul_matrix_mul_into(&a, &b, &out) == 0 && max_abs_diff(&out, ref) < 1e-5);
+
+    picky_test(t, "saul_gemm() still rejects an output view over an input");
+    Matrix over;
+    saul_view_into(&over, m, 30, 25, 60, 70);
+    picky_assert(t, saul_matrix_mul_into(&a, &b, &over) < 0);
+
+    picky_test(t, "saul_lu() factors a block in place through a view");
+    Matrix blk;
+    saul_view_into(&blk, m, 65, 65, 65, 65);
+    for(int i = 0; i < 65; i++) SAUL_AT(&blk, i, i) += 65;
+    Matrix *copy = saul_new_matrix(65, 65);
+    saul_matrix_add(copy, &blk);
+    int piv[65];
+    Matrix *x = saul_new_matrix(65, 1);
+    Matrix *ones = saul_new_matrix(65, 1);
+    for(int i = 0; i < 65; i++) SAUL_AT(ones, i, 0) = 1;
+    saul_matrix_mul_into(copy, ones, x);
+    picky_assert(t, saul_lu(&blk, piv) == 0 && saul_lu_solve(&blk, piv, x) == 0 && max_abs_diff(x, ones) < 1e-4);
+
+    picky_test(t, "freeing views leaves the parent intact");
+    saul_free_matrix(v);
+    saul_free_matrix(r);
+    saul_free_matrix(c);
+    saul_free_matrix(d);
+    picky_float_toBe(t, 42.0f, SAUL_AT(m, 12, 23));
+
+    saul_free_matrix(m);
+    saul_free_matrix(expect);
+    saul_free_matrix(ac);
+    saul_free_matrix(bc);
+    saul_free_matrix(ref);
+    saul_free_matrix(copy);
+    saul_free_matrix(x);
+    saul_free_matrix(ones);
+}
+
+static void halve_row(float *row, int n, void *ctx) {
+    for(int j = 0; j < n; j++) row[j] *= *(float *)ctx;
+}
+
+static void sum_rows(float *row1, float *row2, int n, void *ctx) {
+    (void)ctx;
+    for(int j = 0; j < n; j++) row1[j] += row2[j];
+}
+
+void matrix_map_test(T *t) {
+    unsigned seed = 41;
+    Matrix *m = saul_new_matrix(37, 53);
+    Matrix *ref = saul_new_matrix(37, 53);
+    Matrix *x = saul_new_matrix(37, 53);
+    fill_random(m, &seed);
+    fill_random(x, &seed);
+
+    picky_test(t, "saul_matrix_for_each_row() hands out whole rows");
+    saul_matrix_add(ref, m);
+    float half = 0.5f;
+    saul_matrix_for_each_row(m, halve_row, &half);
+    SAUL_MAP(ref, v, v * 0.5f);
+    picky_assert(t, max_abs_diff(m, ref) == 0);
+
+    picky_test(t, "saul_matrix_for_each_row_double() accepts matching shapes");
+    picky_int_toBe(t, 0, saul_matrix_for_each_row_double(m, x, sum_rows, NULL));
+
+    picky_test(t, "saul_matrix_for_each_row_double() pairs rows of both matrices");
+    SAUL_MAP2(ref, x, p, q, p + q);
+    picky_assert(t, max_abs_diff(m, ref) == 0);
+
+    const char *names[] = {
+        "scale/axpy/clamp/relu/exp match the reference on scalar",
+        "scale/axpy/clamp/relu/exp match the reference on sse2",
+        "scale/axpy/clamp/relu/exp match the reference on avx2",
+        "scale/axpy/clamp/relu/exp match the reference on avx512"
+    };
+    for(int isa = SAUL_ISA_SCALAR; isa <= SAUL_ISA_AVX512; isa++) {
+        if(saul_set_isa((saul_isa)isa) < 0) {
+            continue;
+        }
+        picky_test(t, names[isa]);
+        Matrix *k = saul_new_matrix(37, 53);
+        Matrix *e = saul_new_matrix(37, 53);
+        saul_matrix_add(k, x);
+
+        saul_matrix_scale(k, 3.0f);
+        SAUL_MAP2(e, x, p, q, q * 3.0f);
+        int ok = max_abs_diff(k, e) == 0;
+
+        saul_matrix_axpy(-2.0f, x, k);
+        SAUL_MAP2(e, x, p, q, p - 2.0f * q);
+        ok &= max_abs_diff(k, e) < 1e-6;
+
+        saul_matrix_clamp(k, -0.2f, 0.3f);
+        SAUL_MAP(e, v, v < -0.2f ? -0.2f : (v > 0.3f ? 0.3f : v));
+        ok &= max_abs_diff(k, e) == 0;
+
+        saul_matrix_add(k, x);
+        saul_matrix_add(e, x);
+        saul_matrix_relu(k);
+        SAUL_MAP(e, v, v > 0 ? v : 0);
+        ok &= max_abs_diff(k, e) == 0;
+
+        // Across the whole range, including both clamps
+        for(int i = 0; i < 37; i++) {
+            for(int j = 0; j < 53; j++) SAUL_AT(k, i, j) = (i * 53 + j) / 1961.0f * 200.0f - 100.0f;
+        }
+        saul_matrix_add_into(k, k, e);
+        saul_matrix_scale(e, 0.5f);
+        saul_matrix_exp(k);
+        for(int i = 0; i < 37; i++) {
+            for(int j = 0; j < 53; j++) {
+                float want = expf(SAUL_AT(e, i, j));
+                float got = SAUL_AT(k, i, j);
+                if(isinf(want)) ok &= isinf(got);
+                else if(want < 1e-37f) ok &= got < 1e-37f;
+                else ok &= fabsf(got - want) <= 1e-6f * want;
+            }
+        }
+        picky_assert(t, ok);
+        saul_free_matrix(k);
+        saul_free_matrix(e);
+    }
+    saul_init();
+
+    picky_test(t, "saul_matrix_axpy() with x == y scales by 1 + alpha");
+    SAUL_MAP2(ref, x, p, q, q);
+    saul_matrix_axpy(0.5f, ref, ref);
+    SAUL_MAP2(m, x, p, q, q * 1.5f);
+    picky_assert(t, max_abs_diff(ref, m) == 0);
+
+    picky_test(t, "saul_matrix_axpy() rejects partially overlapping views");
+    Matrix *lo = saul_view(x, 0, 0, 8, 8);
+    Matrix *hi = saul_view(x, 4, 4, 8, 8);
+    picky_int_toBe(t, -1, saul_matrix_axpy(1.0f, lo, hi));
+    saul_free_matrix(lo);
+    saul_free_matrix(hi);
+
+    saul_free_matrix(m);
+    saul_free_matrix(ref);
+    saul_free_matrix(x);
+}
+
+void matrix_types_test(T *t) {
+    unsigned seed = 43;
+    int n = 37;
+    MatrixF64 *a = saul_f64_new_matrix(n, n);
+    MatrixF64 *b = saul_f64_new_matrix(n, 3);
+    MatrixF64 *x = saul_f64_new_matrix(n, 3);
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < n; j++) SAUL_AT(a, i, j) = (double)rand_r(&seed) / RAND_MAX - 0.5;
+        SAUL_AT(a, i, i) += n;
+        for(int j = 0; j < 3; j++) SAUL_AT(x, i, j) = (double)rand_r(&seed) / RAND_MAX - 0.5;
+    }
+
+    picky_test(t, "saul_f64_matrix_mul() not null");
+    MatrixF64 *ax = saul_f64_matrix_mul(a, x);
+    picky_assertNotNull(t, ax);
+
+    picky_test(t, "saul_f64_matrix_mul() matches the triple loop");
+    double err = 0;
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < 3; j++) {
+            double want = 0;
+            for(int k = 0; k < n; k++) want += SAUL_AT(a, i, k) * SAUL_AT(x, k, j);
+            err = fmax(err, fabs(SAUL_AT(ax, i, j) - want));
+        }
+    }
+    picky_assert(t, err < 1e-12);
+
+    picky_test(t, "saul_f64_lu() factors a nonsingular matrix");
+    MatrixF64 *lu = saul_f64_new_matrix(n, n);
+    saul_f64_matrix_add_into(lu, a, lu);
+    int piv[37];
+    picky_int_toBe(t, 0, saul_f64_lu(lu, piv));
+
+    picky_test(t, "saul_f64_lu_solve() succeeds");
+    saul_f64_matrix_add_into(ax, b, b);
+    picky_int_toBe(t, 0, saul_f64_lu_solve(lu, piv, b));
+
+    picky_test(t, "saul_f64_lu_solve() recovers x to double precision");
+    saul_f64_matrix_sub(b, x);
+    err = 0;
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < 3; j++) err = fmax(err, fabs(SAUL_AT(b, i, j)));
+    }
+    picky_assert(t, err < 1e-12);
+
+    picky_test(t, "saul_f64_det() of a singular matrix is 0");
+    MatrixF64 *s = saul_f64_new_matrix(3, 3);
+    for(int i = 0; i < 3; i++) {
+        for(int j = 0; j < 3; j++) saul_f64_matrix_set_value(s, i, j, i * 3 + j);
+    }
+    picky_assert(t, saul_f64_det(s) == 0);
+
+    picky_test(t, "saul_f64_det() of a nonsingular matrix");
+    saul_f64_matrix_set_value(s, 2, 2, 9);
+    picky_assert(t, fabs(saul_f64_det(s) + 3) < 1e-12);
+
+    picky_test(t, "saul_f64_matrix_transpose_into() succeeds");
+    MatrixF64 *at = saul_f64_new_matrix(n, n);
+    picky_int_toBe(t, 0, saul_f64_matrix_transpose_into(a, at));
+
+    picky_test(t, "saul_f64_cholesky() factors A^T A");
+    MatrixF64 *spd = saul_f64_matrix_mul(at, a);
+    MatrixF64 *rhs = saul_f64_matrix_mul(spd, x);
+    picky_int_toBe(t, 0, saul_f64_cholesky(spd));
+
+    picky_test(t, "saul_f64_cholesky_solve() succeeds");
+    picky_int_toBe(t, 0, saul_f64_cholesky_solve(spd, rhs));
+
+    picky_test(t, "saul_f64_cholesky_solve() recovers x from A^T A");
+    saul_f64_matrix_axpy(-1.0, x, rhs);
+    err = 0;
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < 3; j++) err = fmax(err, fabs(SAUL_AT(rhs, i, j)));
+    }
+    picky_assert(t, err < 1e-12);
+
+    const char *names[] = {
+        "int32/int8 add, sub, scale and mul match the reference on scalar",
+        "int32/int8 add, sub, scale and mul match the reference on sse2",
+        "int32/int8 add, sub, scale and mul match the reference on avx2",
+        "int32/int8 add, sub, scale and mul match the reference on avx512"
+    };
+    for(int isa = SAUL_ISA_SCALAR; isa <= SAUL_ISA_AVX512; isa++) {
+        if(saul_set_isa((saul_isa)isa) < 0) {
+            continue;
+        }
+        picky_test(t, names[isa]);
+        MatrixI32 *p = saul_i32_new_matrix(n, 75);
+        MatrixI32 *q = saul_i32_new_matrix(75, n);
+        MatrixI8 *u = saul_i8_new_matrix(n, 75);
+        MatrixI8 *v = saul_i8_new_matrix(n, 75);
+        for(int i = 0; i < n; i++) {
+            for(int j = 0; j < 75; j++) {
+                SAUL_AT(p, i, j) = i * 75 + j - 1000;
+                SAUL_AT(q, j, i) = (i + j) % 7 - 3;
+                SAUL_AT(u, i, j) = (int8_t)(i * 75 + j);
+                SAUL_AT(v, i, j) = (int8_t)(j * 3);
+            }
+        }
+        MatrixI32 *pq = saul_i32_matrix_mul(p, q);
+        saul_i32_matrix_scale(p, 3);
+        saul_i32_matrix_sub(p, p);
+        saul_i8_matrix_add(u, v);
+        saul_i8_matrix_scale(v, 2);
+        int ok = pq != NULL;
+        for(int i = 0; i < n && ok; i++) {
+            for(int j = 0; j < n; j++) {
+                int32_t want = 0;
+                for(int k = 0; k < 75; k++) want += (k + i * 75 - 1000) * ((j + k) % 7 - 3);
+                ok &= SAUL_AT(pq, i, j) == want;
+            }
+            for(int j = 0; j < 75; j++) {
+                ok &= SAUL_AT(p, i, j) == 0;
+                // int8 wraps like C arithmetic
+                ok &= SAUL_AT(u, i, j) == (int8_t)(i * 75 + j + j * 3);
+                ok &= SAUL_AT(v, i, j) == (int8_t)(j * 6);
+            }
+        }
+        picky_assert(t, ok);
+        saul_i32_free_matrix(p);
+        saul_i32_free_matrix(q);
+        saul_i32_free_matrix(pq);
+        saul_i8_free_matrix(u);
+        saul_i8_free_matrix(v);
+    }
+    saul_init();
+
+    picky_test(t, "saul_f64_matrix_add() rejects mismatched shapes");
+    picky_int_toBe(t, -1, saul_f64_matrix_add(a, b));
+
+    picky_test(t, "saul_f64_matrix_mul() rejects mismatched shapes");
+    picky_assert(t, saul_f64_matrix_mul(x, a) == NULL);
+
+    picky_test(t, "saul_f64_matrix_set_value() checks bounds");
+    picky_int_toBe(t, -1, saul_f64_matrix_set_value(a, n, 0, 1.0));
+
+    picky_test(t, "saul_f64_cholesky() rejects non-square input");
+    picky_int_toBe(t, -1, saul_f64_cholesky(b));
+
+    picky_test(t, "saul_f64_matrix_mul_into() rejects an output overlapping an input");
+    MatrixF64 *lo = saul_f64_view(a, 0, 0, 8, 8);
+    MatrixF64 *hi = saul_f64_view(a, 4, 4, 8, 8);
+    picky_int_toBe(t, -1, saul_f64_matrix_mul_into(lo, lo, hi));
+
+    picky_test(t, "saul_f64_matrix_transpose_into() rejects overlapping views");
+    picky_int_toBe(t, -1, saul_f64_matrix_transpose_into(lo, hi));
+    saul_f64_free_matrix(lo);
+    saul_f64_free_matrix(hi);
+
+    picky_test(t, "saul_i8_matrix_axpy() with x == y scales by 1 + alpha");
+    MatrixI8 *w = saul_i8_new_matrix(3, 70);
+    for(int j = 0; j < 70; j++) SAUL_AT(w, 2, j) = (int8_t)(j - 35);
+    saul_i8_matrix_axpy(2, w, w);
+    int tripled = 1;
+    for(int j = 0; j < 70; j++) tripled &= SAUL_AT(w, 2, j) == (int8_t)(3 * (j - 35));
+    picky_assert(t, tripled);
+    saul_i8_free_matrix(w);
+
+    picky_test(t, "saul_f32_* names the float API");
+    MatrixF32 *f = saul_f32_new_matrix(2, 2);
+    saul_f32_matrix_set_value(f, 1, 1, 2.5f);
+    picky_float_toBe(t, 2.5f, saul_f32_get_value_by_index(f, 1, 1));
+    saul_f32_free_matrix(f);
+
+    saul_f64_free_matrix(a);
+    saul_f64_free_matrix(b);
+    saul_f64_free_matrix(x);
+    saul_f64_free_matrix(ax);
+    saul_f64_free_matrix(lu);
+    saul_f64_free_matrix(s);
+    saul_f64_free_matrix(at);
+    saul_f64_free_matrix(spd);
+    saul_f64_free_matrix(rhs);
+}
+
 int main(int argc, char **argv) {
     picky_describe("Matrix Setup Testing", matrix_setup_test);
     picky_describe("Matrix Utilities Testing", matrix_utilities_test);
     picky_describe("Matrix Operations Testing", matrix_operations_test);
+    picky_describe("Matrix GEMM Testing", matrix_gemm_test);
+    picky_describe("Matrix CPU Dispatch Testing", matrix_dispatch_test);
+    picky_describe("Matrix Threads Testing", matrix_threads_test);
+    picky_describe("Matrix Into Testing", matrix_into_test);
+    picky_describe("Matrix LU Testing", matrix_lu_test);
+    picky_describe("Matrix Cholesky Testing", matrix_cholesky_test);
+    picky_describe("Matrix QR Testing", matrix_qr_test);
+    picky_describe("Sparse Matrix Testing", matrix_sparse_test);
+    picky_describe("Matrix View Testing", matrix_view_test);
+    picky_describe("Matrix Map Testing", matrix_map_test);
+    picky_describe("Matrix Types Testing", matrix_types_test);
 }
\ No newline at end of file